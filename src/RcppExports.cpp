@@ -6,6 +6,144 @@
 
 using namespace Rcpp;
 
+// integrated_autocorr_time
+NumericVector integrated_autocorr_time(const NumericMatrix& x);
+RcppExport SEXP _serosolver_integrated_autocorr_time(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(integrated_autocorr_time(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pack_titre_data
+RawVector pack_titre_data(const NumericVector& titres, const IntegerVector& measurement_strain_indices);
+RcppExport SEXP _serosolver_pack_titre_data(SEXP titresSEXP, SEXP measurement_strain_indicesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type titres(titresSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type measurement_strain_indices(measurement_strain_indicesSEXP);
+    rcpp_result_gen = Rcpp::wrap(pack_titre_data(titres, measurement_strain_indices));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pack_repeat_titre_data
+RawVector pack_repeat_titre_data(const NumericVector& repeat_titres, const IntegerVector& repeat_indices, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& cum_nrows_per_individual_in_repeat_data);
+RcppExport SEXP _serosolver_pack_repeat_titre_data(SEXP repeat_titresSEXP, SEXP repeat_indicesSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP cum_nrows_per_individual_in_repeat_dataSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type repeat_titres(repeat_titresSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type repeat_indices(repeat_indicesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_repeat_data(cum_nrows_per_individual_in_repeat_dataSEXP);
+    rcpp_result_gen = Rcpp::wrap(pack_repeat_titre_data(repeat_titres, repeat_indices, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data));
+    return rcpp_result_gen;
+END_RCPP
+}
+// unpack_titre_data
+List unpack_titre_data(const RawVector& packed);
+RcppExport SEXP _serosolver_unpack_titre_data(SEXP packedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const RawVector& >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(unpack_titre_data(packed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// phi_gmrf_log_prior
+double phi_gmrf_log_prior(const NumericVector& phis, double rw_sd, int rw_order, double level_precision);
+RcppExport SEXP _serosolver_phi_gmrf_log_prior(SEXP phisSEXP, SEXP rw_sdSEXP, SEXP rw_orderSEXP, SEXP level_precisionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type phis(phisSEXP);
+    Rcpp::traits::input_parameter< double >::type rw_sd(rw_sdSEXP);
+    Rcpp::traits::input_parameter< int >::type rw_order(rw_orderSEXP);
+    Rcpp::traits::input_parameter< double >::type level_precision(level_precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(phi_gmrf_log_prior(phis, rw_sd, rw_order, level_precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// phi_gmrf_block_update
+List phi_gmrf_block_update(const NumericVector& phis, const NumericVector& n_infections, const NumericVector& n_at_risk, double rw_sd, int rw_order, double level_precision, const Nullable<Function>& log_prior);
+RcppExport SEXP _serosolver_phi_gmrf_block_update(SEXP phisSEXP, SEXP n_infectionsSEXP, SEXP n_at_riskSEXP, SEXP rw_sdSEXP, SEXP rw_orderSEXP, SEXP level_precisionSEXP, SEXP log_priorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type phis(phisSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type n_infections(n_infectionsSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type n_at_risk(n_at_riskSEXP);
+    Rcpp::traits::input_parameter< double >::type rw_sd(rw_sdSEXP);
+    Rcpp::traits::input_parameter< int >::type rw_order(rw_orderSEXP);
+    Rcpp::traits::input_parameter< double >::type level_precision(level_precisionSEXP);
+    Rcpp::traits::input_parameter< const Nullable<Function>& >::type log_prior(log_priorSEXP);
+    rcpp_result_gen = Rcpp::wrap(phi_gmrf_block_update(phis, n_infections, n_at_risk, rw_sd, rw_order, level_precision, log_prior));
+    return rcpp_result_gen;
+END_RCPP
+}
+// create_group_time_counts
+SEXP create_group_time_counts(const IntegerVector& age_mask, const IntegerVector& strain_mask, const IntegerVector& group_id_vec, int n_times, const Nullable<IntegerMatrix>& n_alive);
+RcppExport SEXP _serosolver_create_group_time_counts(SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP group_id_vecSEXP, SEXP n_timesSEXP, SEXP n_aliveSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const IntegerVector& >::type age_mask(age_maskSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type strain_mask(strain_maskSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type group_id_vec(group_id_vecSEXP);
+    Rcpp::traits::input_parameter< int >::type n_times(n_timesSEXP);
+    Rcpp::traits::input_parameter< const Nullable<IntegerMatrix>& >::type n_alive(n_aliveSEXP);
+    rcpp_result_gen = Rcpp::wrap(create_group_time_counts(age_mask, strain_mask, group_id_vec, n_times, n_alive));
+    return rcpp_result_gen;
+END_RCPP
+}
+// group_time_counts_sync
+void group_time_counts_sync(SEXP group_counts, const IntegerMatrix& infection_history_mat);
+RcppExport SEXP _serosolver_group_time_counts_sync(SEXP group_countsSEXP, SEXP infection_history_matSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type group_counts(group_countsSEXP);
+    Rcpp::traits::input_parameter< const IntegerMatrix& >::type infection_history_mat(infection_history_matSEXP);
+    group_time_counts_sync(group_counts, infection_history_mat);
+    return R_NilValue;
+END_RCPP
+}
+// group_time_counts_log_prior
+double group_time_counts_log_prior(SEXP group_counts, double alpha, double beta, bool prior_on_total);
+RcppExport SEXP _serosolver_group_time_counts_log_prior(SEXP group_countsSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP prior_on_totalSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type group_counts(group_countsSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< bool >::type prior_on_total(prior_on_totalSEXP);
+    rcpp_result_gen = Rcpp::wrap(group_time_counts_log_prior(group_counts, alpha, beta, prior_on_total));
+    return rcpp_result_gen;
+END_RCPP
+}
+// group_time_counts_dense
+List group_time_counts_dense(SEXP group_counts);
+RcppExport SEXP _serosolver_group_time_counts_dense(SEXP group_countsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type group_counts(group_countsSEXP);
+    rcpp_result_gen = Rcpp::wrap(group_time_counts_dense(group_counts));
+    return rcpp_result_gen;
+END_RCPP
+}
+// group_time_counts_infections_by_time
+NumericVector group_time_counts_infections_by_time(SEXP group_counts);
+RcppExport SEXP _serosolver_group_time_counts_infections_by_time(SEXP group_countsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type group_counts(group_countsSEXP);
+    rcpp_result_gen = Rcpp::wrap(group_time_counts_infections_by_time(group_counts));
+    return rcpp_result_gen;
+END_RCPP
+}
 // subset_nullable_vector
 NumericVector subset_nullable_vector(const Nullable<NumericVector>& x, int index1, int index2);
 RcppExport SEXP _serosolver_subset_nullable_vector(SEXP xSEXP, SEXP index1SEXP, SEXP index2SEXP) {
@@ -106,6 +244,82 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// titre_data_fast_packed
+NumericVector titre_data_fast_packed(const NumericVector& theta, const IntegerMatrix& infection_history_mat, const NumericVector& circulation_times, const IntegerVector& circulation_times_indices, const NumericVector& sample_times, const IntegerVector& rows_per_indiv_in_samples, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& nrows_per_blood_sample, const RawVector& packed_titres, const NumericVector& antigenic_map_long, const NumericVector& antigenic_map_short, const NumericVector& antigenic_distances, const NumericVector& mus, const IntegerVector& boosting_vec_indices, const NumericMatrix& indiv_effects, bool boost_before_infection, const List& kinetics);
+RcppExport SEXP _serosolver_titre_data_fast_packed(SEXP thetaSEXP, SEXP infection_history_matSEXP, SEXP circulation_timesSEXP, SEXP circulation_times_indicesSEXP, SEXP sample_timesSEXP, SEXP rows_per_indiv_in_samplesSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP nrows_per_blood_sampleSEXP, SEXP packed_titresSEXP, SEXP antigenic_map_longSEXP, SEXP antigenic_map_shortSEXP, SEXP antigenic_distancesSEXP, SEXP musSEXP, SEXP boosting_vec_indicesSEXP, SEXP indiv_effectsSEXP, SEXP boost_before_infectionSEXP, SEXP kineticsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< const IntegerMatrix& >::type infection_history_mat(infection_history_matSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type circulation_times(circulation_timesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type circulation_times_indices(circulation_times_indicesSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type sample_times(sample_timesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type rows_per_indiv_in_samples(rows_per_indiv_in_samplesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nrows_per_blood_sample(nrows_per_blood_sampleSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_titres(packed_titresSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_long(antigenic_map_longSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_short(antigenic_map_shortSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_distances(antigenic_distancesSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type mus(musSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type boosting_vec_indices(boosting_vec_indicesSEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type indiv_effects(indiv_effectsSEXP);
+    Rcpp::traits::input_parameter< bool >::type boost_before_infection(boost_before_infectionSEXP);
+    Rcpp::traits::input_parameter< const List& >::type kinetics(kineticsSEXP);
+    rcpp_result_gen = Rcpp::wrap(titre_data_fast_packed(theta, infection_history_mat, circulation_times, circulation_times_indices, sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data, nrows_per_blood_sample, packed_titres, antigenic_map_long, antigenic_map_short, antigenic_distances, mus, boosting_vec_indices, indiv_effects, boost_before_infection, kinetics));
+    return rcpp_result_gen;
+END_RCPP
+}
+// likelihood_early_rejection_packed
+List likelihood_early_rejection_packed(const NumericVector& theta, const IntegerMatrix& infection_history_mat, const NumericVector& circulation_times, const IntegerVector& circulation_times_indices, const NumericVector& sample_times, const IntegerVector& rows_per_indiv_in_samples, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& cum_nrows_per_individual_in_repeat_data, const IntegerVector& nrows_per_blood_sample, const RawVector& packed_titres, const RawVector& packed_repeat_titres, const NumericVector& antigenic_map_long, const NumericVector& antigenic_map_short, const NumericVector& antigenic_distances, const NumericVector& mus, const IntegerVector& boosting_vec_indices, const NumericMatrix& indiv_effects, const NumericVector& titre_shifts, const IntegerVector& indiv_order, double threshold, const List& kinetics);
+RcppExport SEXP _serosolver_likelihood_early_rejection_packed(SEXP thetaSEXP, SEXP infection_history_matSEXP, SEXP circulation_timesSEXP, SEXP circulation_times_indicesSEXP, SEXP sample_timesSEXP, SEXP rows_per_indiv_in_samplesSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP cum_nrows_per_individual_in_repeat_dataSEXP, SEXP nrows_per_blood_sampleSEXP, SEXP packed_titresSEXP, SEXP packed_repeat_titresSEXP, SEXP antigenic_map_longSEXP, SEXP antigenic_map_shortSEXP, SEXP antigenic_distancesSEXP, SEXP musSEXP, SEXP boosting_vec_indicesSEXP, SEXP indiv_effectsSEXP, SEXP titre_shiftsSEXP, SEXP indiv_orderSEXP, SEXP thresholdSEXP, SEXP kineticsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< const IntegerMatrix& >::type infection_history_mat(infection_history_matSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type circulation_times(circulation_timesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type circulation_times_indices(circulation_times_indicesSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type sample_times(sample_timesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type rows_per_indiv_in_samples(rows_per_indiv_in_samplesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_repeat_data(cum_nrows_per_individual_in_repeat_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nrows_per_blood_sample(nrows_per_blood_sampleSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_titres(packed_titresSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_repeat_titres(packed_repeat_titresSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_long(antigenic_map_longSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_short(antigenic_map_shortSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_distances(antigenic_distancesSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type mus(musSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type boosting_vec_indices(boosting_vec_indicesSEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type indiv_effects(indiv_effectsSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type titre_shifts(titre_shiftsSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type indiv_order(indiv_orderSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const List& >::type kinetics(kineticsSEXP);
+    rcpp_result_gen = Rcpp::wrap(likelihood_early_rejection_packed(theta, infection_history_mat, circulation_times, circulation_times_indices, sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data, nrows_per_blood_sample, packed_titres, packed_repeat_titres, antigenic_map_long, antigenic_map_short, antigenic_distances, mus, boosting_vec_indices, indiv_effects, titre_shifts, indiv_order, threshold, kinetics));
+    return rcpp_result_gen;
+END_RCPP
+}
+// titres_at_infection_times
+NumericMatrix titres_at_infection_times(const NumericVector& theta, const IntegerMatrix& infection_history_mat, const NumericVector& circulation_times, const IntegerVector& circulation_times_indices, const IntegerVector& age_mask, const IntegerVector& strain_mask, const NumericVector& antigenic_map_long, const NumericVector& antigenic_map_short, const NumericVector& mus, const IntegerVector& boosting_vec_indices, const NumericMatrix& indiv_effects);
+RcppExport SEXP _serosolver_titres_at_infection_times(SEXP thetaSEXP, SEXP infection_history_matSEXP, SEXP circulation_timesSEXP, SEXP circulation_times_indicesSEXP, SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP antigenic_map_longSEXP, SEXP antigenic_map_shortSEXP, SEXP musSEXP, SEXP boosting_vec_indicesSEXP, SEXP indiv_effectsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< const IntegerMatrix& >::type infection_history_mat(infection_history_matSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type circulation_times(circulation_timesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type circulation_times_indices(circulation_times_indicesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type age_mask(age_maskSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type strain_mask(strain_maskSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_long(antigenic_map_longSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_short(antigenic_map_shortSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type mus(musSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type boosting_vec_indices(boosting_vec_indicesSEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type indiv_effects(indiv_effectsSEXP);
+    rcpp_result_gen = Rcpp::wrap(titres_at_infection_times(theta, infection_history_mat, circulation_times, circulation_times_indices, age_mask, strain_mask, antigenic_map_long, antigenic_map_short, mus, boosting_vec_indices, indiv_effects));
+    return rcpp_result_gen;
+END_RCPP
+}
 // inf_mat_prior_cpp
 double inf_mat_prior_cpp(const IntegerMatrix& infection_history, const IntegerVector& n_alive, double alpha, double beta);
 RcppExport SEXP _serosolver_inf_mat_prior_cpp(SEXP infection_historySEXP, SEXP n_aliveSEXP, SEXP alphaSEXP, SEXP betaSEXP) {
@@ -188,6 +402,57 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// likelihood_func_fast_packed
+NumericVector likelihood_func_fast_packed(const NumericVector& theta, const RawVector& packed_titres, const NumericVector& predicted_titres, const IntegerVector& cum_nrows_per_individual_in_data);
+RcppExport SEXP _serosolver_likelihood_func_fast_packed(SEXP thetaSEXP, SEXP packed_titresSEXP, SEXP predicted_titresSEXP, SEXP cum_nrows_per_individual_in_dataSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_titres(packed_titresSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type predicted_titres(predicted_titresSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    rcpp_result_gen = Rcpp::wrap(likelihood_func_fast_packed(theta, packed_titres, predicted_titres, cum_nrows_per_individual_in_data));
+    return rcpp_result_gen;
+END_RCPP
+}
+// likelihood_func_fast_packed_repeats
+NumericVector likelihood_func_fast_packed_repeats(const NumericVector& theta, const RawVector& packed_repeat_titres, const NumericVector& predicted_titres, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& cum_nrows_per_individual_in_repeat_data);
+RcppExport SEXP _serosolver_likelihood_func_fast_packed_repeats(SEXP thetaSEXP, SEXP packed_repeat_titresSEXP, SEXP predicted_titresSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP cum_nrows_per_individual_in_repeat_dataSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_repeat_titres(packed_repeat_titresSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type predicted_titres(predicted_titresSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_repeat_data(cum_nrows_per_individual_in_repeat_dataSEXP);
+    rcpp_result_gen = Rcpp::wrap(likelihood_func_fast_packed_repeats(theta, packed_repeat_titres, predicted_titres, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data));
+    return rcpp_result_gen;
+END_RCPP
+}
+// stream_preprocess_titre_csv
+List stream_preprocess_titre_csv(const std::string& csv_file, const std::string& output_file, const NumericVector& strain_isolation_times, const int& chunk_size, const std::string& scratch_prefix);
+RcppExport SEXP _serosolver_stream_preprocess_titre_csv(SEXP csv_fileSEXP, SEXP output_fileSEXP, SEXP strain_isolation_timesSEXP, SEXP chunk_sizeSEXP, SEXP scratch_prefixSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type csv_file(csv_fileSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type output_file(output_fileSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type strain_isolation_times(strain_isolation_timesSEXP);
+    Rcpp::traits::input_parameter< const int& >::type chunk_size(chunk_sizeSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type scratch_prefix(scratch_prefixSEXP);
+    rcpp_result_gen = Rcpp::wrap(stream_preprocess_titre_csv(csv_file, output_file, strain_isolation_times, chunk_size, scratch_prefix));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_preprocessed_titre_data
+List read_preprocessed_titre_data(const std::string& file);
+RcppExport SEXP _serosolver_read_preprocessed_titre_data(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_preprocessed_titre_data(file));
+    return rcpp_result_gen;
+END_RCPP
+}
 // inf_hist_prop_prior_v3
 arma::mat inf_hist_prop_prior_v3(arma::mat infection_history_mat, const IntegerVector& sampled_indivs, const IntegerVector& age_mask, const IntegerVector& strain_mask, const IntegerVector& move_sizes, const IntegerVector& n_infs, double alpha, double beta, const NumericVector& rand_ns, const double& swap_propn);
 RcppExport SEXP _serosolver_inf_hist_prop_prior_v3(SEXP infection_history_matSEXP, SEXP sampled_indivsSEXP, SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP move_sizesSEXP, SEXP n_infsSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP rand_nsSEXP, SEXP swap_propnSEXP) {
@@ -209,8 +474,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // inf_hist_prop_prior_v2_and_v4
-List inf_hist_prop_prior_v2_and_v4(const NumericVector& theta, const IntegerMatrix& infection_history_mat, const NumericVector& old_probs_1, const IntegerVector& sampled_indivs, const IntegerVector& n_years_samp_vec, const IntegerVector& age_mask, const IntegerVector& strain_mask, const IntegerMatrix& n_alive, IntegerMatrix& n_infections, IntegerVector& n_infected_group, const NumericMatrix& prior_lookup, const double& swap_propn, const int& swap_distance, const bool& propose_from_prior, const double& alpha, const double& beta, const NumericVector& circulation_times, const IntegerVector& circulation_times_indices, const NumericVector& sample_times, const IntegerVector& rows_per_indiv_in_samples, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& cum_nrows_per_individual_in_repeat_data, const IntegerVector& nrows_per_blood_sample, const IntegerVector& group_id_vec, const IntegerVector& measurement_strain_indices, const NumericVector& antigenic_map_long, const NumericVector& antigenic_map_short, const NumericVector& antigenic_distances, const NumericVector& data, const NumericVector& repeat_data, const IntegerVector& repeat_indices, const NumericVector& titre_shifts, IntegerVector proposal_iter, IntegerVector accepted_iter, IntegerVector proposal_swap, IntegerVector accepted_swap, IntegerMatrix overall_swap_proposals, IntegerMatrix overall_add_proposals, const NumericVector time_sample_probs, const NumericVector& mus, const IntegerVector& boosting_vec_indices, const IntegerVector& total_alive, const double temp, bool solve_likelihood);
-RcppExport SEXP _serosolver_inf_hist_prop_prior_v2_and_v4(SEXP thetaSEXP, SEXP infection_history_matSEXP, SEXP old_probs_1SEXP, SEXP sampled_indivsSEXP, SEXP n_years_samp_vecSEXP, SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP n_aliveSEXP, SEXP n_infectionsSEXP, SEXP n_infected_groupSEXP, SEXP prior_lookupSEXP, SEXP swap_propnSEXP, SEXP swap_distanceSEXP, SEXP propose_from_priorSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP circulation_timesSEXP, SEXP circulation_times_indicesSEXP, SEXP sample_timesSEXP, SEXP rows_per_indiv_in_samplesSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP cum_nrows_per_individual_in_repeat_dataSEXP, SEXP nrows_per_blood_sampleSEXP, SEXP group_id_vecSEXP, SEXP measurement_strain_indicesSEXP, SEXP antigenic_map_longSEXP, SEXP antigenic_map_shortSEXP, SEXP antigenic_distancesSEXP, SEXP dataSEXP, SEXP repeat_dataSEXP, SEXP repeat_indicesSEXP, SEXP titre_shiftsSEXP, SEXP proposal_iterSEXP, SEXP accepted_iterSEXP, SEXP proposal_swapSEXP, SEXP accepted_swapSEXP, SEXP overall_swap_proposalsSEXP, SEXP overall_add_proposalsSEXP, SEXP time_sample_probsSEXP, SEXP musSEXP, SEXP boosting_vec_indicesSEXP, SEXP total_aliveSEXP, SEXP tempSEXP, SEXP solve_likelihoodSEXP) {
+List inf_hist_prop_prior_v2_and_v4(const NumericVector& theta, const IntegerMatrix& infection_history_mat, const NumericVector& old_probs_1, const IntegerVector& sampled_indivs, const IntegerVector& n_years_samp_vec, const IntegerVector& age_mask, const IntegerVector& strain_mask, SEXP group_counts, const bool& prior_on_total, const double& swap_propn, const int& swap_distance, const bool& propose_from_prior, const double& alpha, const double& beta, const NumericVector& circulation_times, const IntegerVector& circulation_times_indices, const NumericVector& sample_times, const IntegerVector& rows_per_indiv_in_samples, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& cum_nrows_per_individual_in_repeat_data, const IntegerVector& nrows_per_blood_sample, const IntegerVector& group_id_vec, const NumericVector& antigenic_map_long, const NumericVector& antigenic_map_short, const NumericVector& antigenic_distances, const RawVector& packed_titres, const RawVector& packed_repeat_titres, const NumericVector& titre_shifts, IntegerVector proposal_iter, IntegerVector accepted_iter, IntegerVector proposal_swap, IntegerVector accepted_swap, IntegerMatrix overall_swap_proposals, IntegerMatrix overall_add_proposals, const NumericVector time_sample_probs, const NumericVector& mus, const IntegerVector& boosting_vec_indices, const NumericMatrix& indiv_effects, const NumericVector& indiv_effect_sds, const double& indiv_effect_step, const NumericMatrix& infection_time_titres, const double& shift_propn, const int& shift_max, const double temp, bool solve_likelihood, const List& kinetics);
+RcppExport SEXP _serosolver_inf_hist_prop_prior_v2_and_v4(SEXP thetaSEXP, SEXP infection_history_matSEXP, SEXP old_probs_1SEXP, SEXP sampled_indivsSEXP, SEXP n_years_samp_vecSEXP, SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP group_countsSEXP, SEXP prior_on_totalSEXP, SEXP swap_propnSEXP, SEXP swap_distanceSEXP, SEXP propose_from_priorSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP circulation_timesSEXP, SEXP circulation_times_indicesSEXP, SEXP sample_timesSEXP, SEXP rows_per_indiv_in_samplesSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP cum_nrows_per_individual_in_repeat_dataSEXP, SEXP nrows_per_blood_sampleSEXP, SEXP group_id_vecSEXP, SEXP antigenic_map_longSEXP, SEXP antigenic_map_shortSEXP, SEXP antigenic_distancesSEXP, SEXP packed_titresSEXP, SEXP packed_repeat_titresSEXP, SEXP titre_shiftsSEXP, SEXP proposal_iterSEXP, SEXP accepted_iterSEXP, SEXP proposal_swapSEXP, SEXP accepted_swapSEXP, SEXP overall_swap_proposalsSEXP, SEXP overall_add_proposalsSEXP, SEXP time_sample_probsSEXP, SEXP musSEXP, SEXP boosting_vec_indicesSEXP, SEXP indiv_effectsSEXP, SEXP indiv_effect_sdsSEXP, SEXP indiv_effect_stepSEXP, SEXP infection_time_titresSEXP, SEXP shift_propnSEXP, SEXP shift_maxSEXP, SEXP tempSEXP, SEXP solve_likelihoodSEXP, SEXP kineticsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -221,10 +486,8 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const IntegerVector& >::type n_years_samp_vec(n_years_samp_vecSEXP);
     Rcpp::traits::input_parameter< const IntegerVector& >::type age_mask(age_maskSEXP);
     Rcpp::traits::input_parameter< const IntegerVector& >::type strain_mask(strain_maskSEXP);
-    Rcpp::traits::input_parameter< const IntegerMatrix& >::type n_alive(n_aliveSEXP);
-    Rcpp::traits::input_parameter< IntegerMatrix& >::type n_infections(n_infectionsSEXP);
-    Rcpp::traits::input_parameter< IntegerVector& >::type n_infected_group(n_infected_groupSEXP);
-    Rcpp::traits::input_parameter< const NumericMatrix& >::type prior_lookup(prior_lookupSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type group_counts(group_countsSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type prior_on_total(prior_on_totalSEXP);
     Rcpp::traits::input_parameter< const double& >::type swap_propn(swap_propnSEXP);
     Rcpp::traits::input_parameter< const int& >::type swap_distance(swap_distanceSEXP);
     Rcpp::traits::input_parameter< const bool& >::type propose_from_prior(propose_from_priorSEXP);
@@ -238,13 +501,11 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_repeat_data(cum_nrows_per_individual_in_repeat_dataSEXP);
     Rcpp::traits::input_parameter< const IntegerVector& >::type nrows_per_blood_sample(nrows_per_blood_sampleSEXP);
     Rcpp::traits::input_parameter< const IntegerVector& >::type group_id_vec(group_id_vecSEXP);
-    Rcpp::traits::input_parameter< const IntegerVector& >::type measurement_strain_indices(measurement_strain_indicesSEXP);
     Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_long(antigenic_map_longSEXP);
     Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_map_short(antigenic_map_shortSEXP);
     Rcpp::traits::input_parameter< const NumericVector& >::type antigenic_distances(antigenic_distancesSEXP);
-    Rcpp::traits::input_parameter< const NumericVector& >::type data(dataSEXP);
-    Rcpp::traits::input_parameter< const NumericVector& >::type repeat_data(repeat_dataSEXP);
-    Rcpp::traits::input_parameter< const IntegerVector& >::type repeat_indices(repeat_indicesSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_titres(packed_titresSEXP);
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_repeat_titres(packed_repeat_titresSEXP);
     Rcpp::traits::input_parameter< const NumericVector& >::type titre_shifts(titre_shiftsSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type proposal_iter(proposal_iterSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type accepted_iter(accepted_iterSEXP);
@@ -255,10 +516,60 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const NumericVector >::type time_sample_probs(time_sample_probsSEXP);
     Rcpp::traits::input_parameter< const NumericVector& >::type mus(musSEXP);
     Rcpp::traits::input_parameter< const IntegerVector& >::type boosting_vec_indices(boosting_vec_indicesSEXP);
-    Rcpp::traits::input_parameter< const IntegerVector& >::type total_alive(total_aliveSEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type indiv_effects(indiv_effectsSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type indiv_effect_sds(indiv_effect_sdsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type indiv_effect_step(indiv_effect_stepSEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type infection_time_titres(infection_time_titresSEXP);
+    Rcpp::traits::input_parameter< const double& >::type shift_propn(shift_propnSEXP);
+    Rcpp::traits::input_parameter< const int& >::type shift_max(shift_maxSEXP);
     Rcpp::traits::input_parameter< const double >::type temp(tempSEXP);
     Rcpp::traits::input_parameter< bool >::type solve_likelihood(solve_likelihoodSEXP);
-    rcpp_result_gen = Rcpp::wrap(inf_hist_prop_prior_v2_and_v4(theta, infection_history_mat, old_probs_1, sampled_indivs, n_years_samp_vec, age_mask, strain_mask, n_alive, n_infections, n_infected_group, prior_lookup, swap_propn, swap_distance, propose_from_prior, alpha, beta, circulation_times, circulation_times_indices, sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data, nrows_per_blood_sample, group_id_vec, measurement_strain_indices, antigenic_map_long, antigenic_map_short, antigenic_distances, data, repeat_data, repeat_indices, titre_shifts, proposal_iter, accepted_iter, proposal_swap, accepted_swap, overall_swap_proposals, overall_add_proposals, time_sample_probs, mus, boosting_vec_indices, total_alive, temp, solve_likelihood));
+    Rcpp::traits::input_parameter< const List& >::type kinetics(kineticsSEXP);
+    rcpp_result_gen = Rcpp::wrap(inf_hist_prop_prior_v2_and_v4(theta, infection_history_mat, old_probs_1, sampled_indivs, n_years_samp_vec, age_mask, strain_mask, group_counts, prior_on_total, swap_propn, swap_distance, propose_from_prior, alpha, beta, circulation_times, circulation_times_indices, sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data, nrows_per_blood_sample, group_id_vec, antigenic_map_long, antigenic_map_short, antigenic_distances, packed_titres, packed_repeat_titres, titre_shifts, proposal_iter, accepted_iter, proposal_swap, accepted_swap, overall_swap_proposals, overall_add_proposals, time_sample_probs, mus, boosting_vec_indices, indiv_effects, indiv_effect_sds, indiv_effect_step, infection_time_titres, shift_propn, shift_max, temp, solve_likelihood, kinetics));
+    return rcpp_result_gen;
+END_RCPP
+}
+// setup_infection_histories_chains
+List setup_infection_histories_chains(const RawVector& packed_titres, const IntegerVector& cum_nrows_per_individual_in_data, const IntegerVector& age_mask, const IntegerVector& strain_mask, const NumericVector& circulation_times, const NumericVector& titre_cutoffs, const NumericVector& sample_probs, const NumericVector& background_probs, const IntegerVector& seeds, int space);
+RcppExport SEXP _serosolver_setup_infection_histories_chains(SEXP packed_titresSEXP, SEXP cum_nrows_per_individual_in_dataSEXP, SEXP age_maskSEXP, SEXP strain_maskSEXP, SEXP circulation_timesSEXP, SEXP titre_cutoffsSEXP, SEXP sample_probsSEXP, SEXP background_probsSEXP, SEXP seedsSEXP, SEXP spaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const RawVector& >::type packed_titres(packed_titresSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_dataSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type age_mask(age_maskSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type strain_mask(strain_maskSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type circulation_times(circulation_timesSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type titre_cutoffs(titre_cutoffsSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type sample_probs(sample_probsSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type background_probs(background_probsSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type seeds(seedsSEXP);
+    Rcpp::traits::input_parameter< int >::type space(spaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(setup_infection_histories_chains(packed_titres, cum_nrows_per_individual_in_data, age_mask, strain_mask, circulation_times, titre_cutoffs, sample_probs, background_probs, seeds, space));
+    return rcpp_result_gen;
+END_RCPP
+}
+// kernel_density_by_group
+List kernel_density_by_group(const NumericVector& values, const IntegerVector& group_starts, int n_points);
+RcppExport SEXP _serosolver_kernel_density_by_group(SEXP valuesSEXP, SEXP group_startsSEXP, SEXP n_pointsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type group_starts(group_startsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_points(n_pointsSEXP);
+    rcpp_result_gen = Rcpp::wrap(kernel_density_by_group(values, group_starts, n_points));
+    return rcpp_result_gen;
+END_RCPP
+}
+// downsample_trace
+IntegerVector downsample_trace(const NumericVector& x, const NumericVector& y, const IntegerVector& series_starts, int n_buckets);
+RcppExport SEXP _serosolver_downsample_trace(SEXP xSEXP, SEXP ySEXP, SEXP series_startsSEXP, SEXP n_bucketsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type series_starts(series_startsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_buckets(n_bucketsSEXP);
+    rcpp_result_gen = Rcpp::wrap(downsample_trace(x, y, series_starts, n_buckets));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -277,6 +588,17 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_serosolver_integrated_autocorr_time", (DL_FUNC) &_serosolver_integrated_autocorr_time, 1},
+    {"_serosolver_pack_titre_data", (DL_FUNC) &_serosolver_pack_titre_data, 2},
+    {"_serosolver_pack_repeat_titre_data", (DL_FUNC) &_serosolver_pack_repeat_titre_data, 4},
+    {"_serosolver_unpack_titre_data", (DL_FUNC) &_serosolver_unpack_titre_data, 1},
+    {"_serosolver_phi_gmrf_log_prior", (DL_FUNC) &_serosolver_phi_gmrf_log_prior, 4},
+    {"_serosolver_phi_gmrf_block_update", (DL_FUNC) &_serosolver_phi_gmrf_block_update, 7},
+    {"_serosolver_create_group_time_counts", (DL_FUNC) &_serosolver_create_group_time_counts, 5},
+    {"_serosolver_group_time_counts_sync", (DL_FUNC) &_serosolver_group_time_counts_sync, 2},
+    {"_serosolver_group_time_counts_log_prior", (DL_FUNC) &_serosolver_group_time_counts_log_prior, 4},
+    {"_serosolver_group_time_counts_dense", (DL_FUNC) &_serosolver_group_time_counts_dense, 1},
+    {"_serosolver_group_time_counts_infections_by_time", (DL_FUNC) &_serosolver_group_time_counts_infections_by_time, 1},
     {"_serosolver_subset_nullable_vector", (DL_FUNC) &_serosolver_subset_nullable_vector, 3},
     {"_serosolver_sum_likelihoods", (DL_FUNC) &_serosolver_sum_likelihoods, 3},
     {"_serosolver_create_cross_reactivity_vector", (DL_FUNC) &_serosolver_create_cross_reactivity_vector, 2},
@@ -284,14 +606,24 @@ static const R_CallMethodDef CallEntries[] = {
     {"_serosolver_sum_infections_by_group", (DL_FUNC) &_serosolver_sum_infections_by_group, 3},
     {"_serosolver_add_measurement_shifts", (DL_FUNC) &_serosolver_add_measurement_shifts, 4},
     {"_serosolver_titre_data_fast", (DL_FUNC) &_serosolver_titre_data_fast, 15},
+    {"_serosolver_titre_data_fast_packed", (DL_FUNC) &_serosolver_titre_data_fast_packed, 17},
+    {"_serosolver_likelihood_early_rejection_packed", (DL_FUNC) &_serosolver_likelihood_early_rejection_packed, 21},
+    {"_serosolver_titres_at_infection_times", (DL_FUNC) &_serosolver_titres_at_infection_times, 11},
     {"_serosolver_inf_mat_prior_cpp", (DL_FUNC) &_serosolver_inf_mat_prior_cpp, 4},
     {"_serosolver_inf_mat_prior_cpp_vector", (DL_FUNC) &_serosolver_inf_mat_prior_cpp_vector, 4},
     {"_serosolver_inf_mat_prior_group_cpp", (DL_FUNC) &_serosolver_inf_mat_prior_group_cpp, 4},
     {"_serosolver_inf_mat_prior_group_cpp_vector", (DL_FUNC) &_serosolver_inf_mat_prior_group_cpp_vector, 4},
     {"_serosolver_inf_mat_prior_total_group_cpp", (DL_FUNC) &_serosolver_inf_mat_prior_total_group_cpp, 4},
     {"_serosolver_likelihood_func_fast", (DL_FUNC) &_serosolver_likelihood_func_fast, 3},
+    {"_serosolver_likelihood_func_fast_packed", (DL_FUNC) &_serosolver_likelihood_func_fast_packed, 4},
+    {"_serosolver_likelihood_func_fast_packed_repeats", (DL_FUNC) &_serosolver_likelihood_func_fast_packed_repeats, 5},
+    {"_serosolver_stream_preprocess_titre_csv", (DL_FUNC) &_serosolver_stream_preprocess_titre_csv, 5},
+    {"_serosolver_read_preprocessed_titre_data", (DL_FUNC) &_serosolver_read_preprocessed_titre_data, 1},
     {"_serosolver_inf_hist_prop_prior_v3", (DL_FUNC) &_serosolver_inf_hist_prop_prior_v3, 10},
-    {"_serosolver_inf_hist_prop_prior_v2_and_v4", (DL_FUNC) &_serosolver_inf_hist_prop_prior_v2_and_v4, 44},
+    {"_serosolver_inf_hist_prop_prior_v2_and_v4", (DL_FUNC) &_serosolver_inf_hist_prop_prior_v2_and_v4, 46},
+    {"_serosolver_setup_infection_histories_chains", (DL_FUNC) &_serosolver_setup_infection_histories_chains, 10},
+    {"_serosolver_kernel_density_by_group", (DL_FUNC) &_serosolver_kernel_density_by_group, 3},
+    {"_serosolver_downsample_trace", (DL_FUNC) &_serosolver_downsample_trace, 4},
     {"_serosolver_wane_function", (DL_FUNC) &_serosolver_wane_function, 3},
     {NULL, NULL, 0}
 };
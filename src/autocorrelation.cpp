@@ -0,0 +1,69 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <cmath>
+#include <vector>
+using namespace Rcpp;
+// [[Rcpp::depends(RcppParallel)]]
+
+// Integrated autocorrelation time of each column, by Geyer's initial monotone sequence
+// estimator. Autocovariances are summed in pairs of lags until a pair is no longer
+// positive, and each pair is capped at the one before, so only as many lags are computed
+// as the chain needs. Columns are independent, so are spread across threads
+struct autocorr_time_worker : public RcppParallel::Worker {
+  const RcppParallel::RMatrix<double> x;
+  RcppParallel::RVector<double> tau;
+
+  autocorr_time_worker(const NumericMatrix &x, NumericVector &tau)
+    : x(x), tau(tau) {}
+
+  void operator()(std::size_t begin, std::size_t end){
+    int n = x.nrow();
+    std::vector<double> centred(n);
+    for(std::size_t col = begin; col < end; ++col){
+      double mean = 0;
+      for(int t = 0; t < n; ++t) mean += x(t, col);
+      mean /= n;
+      for(int t = 0; t < n; ++t) centred[t] = x(t, col) - mean;
+
+      double gamma0 = 0;
+      for(int t = 0; t < n; ++t) gamma0 += centred[t]*centred[t];
+      gamma0 /= n;
+      if(!(gamma0 > 0) || !std::isfinite(gamma0)){
+	tau[col] = NA_REAL;
+	continue;
+      }
+
+      double total = -gamma0;
+      double last_pair = R_PosInf;
+      for(int lag = 0; lag + 1 < n; lag += 2){
+	double gamma_a = 0, gamma_b = 0;
+	for(int t = 0; t + lag < n; ++t) gamma_a += centred[t]*centred[t + lag];
+	for(int t = 0; t + lag + 1 < n; ++t) gamma_b += centred[t]*centred[t + lag + 1];
+	double pair = (gamma_a + gamma_b)/n;
+	if(pair <= 0) break;
+	pair = std::min(pair, last_pair);
+	total += 2*pair;
+	last_pair = pair;
+      }
+      tau[col] = std::max(1.0, total/gamma0);
+    }
+  }
+};
+
+//' Integrated autocorrelation times of MCMC traces
+//'
+//' Estimates the integrated autocorrelation time of each column of a matrix of MCMC samples, using Geyer's initial monotone sequence estimator. The effective sample size of a column is its number of rows divided by its autocorrelation time, so a chain thinned to every ceiling(tau) samples has roughly one effective sample per saved draw. Columns are handled on separate threads.
+//' @param x NumericMatrix, one column per quantity and one row per iteration
+//' @return NumericVector of autocorrelation times, at least 1, or NA for columns that never change
+//' @family mcmc
+//' @export
+// [[Rcpp::export(rng = false)]]
+NumericVector integrated_autocorr_time(const NumericMatrix &x){
+  NumericVector tau(x.ncol());
+  if(x.nrow() < 2){
+    Rcpp::stop("Need at least two samples to estimate autocorrelation times");
+  }
+  autocorr_time_worker worker(x, tau);
+  RcppParallel::parallelFor(0, x.ncol(), worker);
+  return(tau);
+}
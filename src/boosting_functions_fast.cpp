@@ -1,4 +1,5 @@
 #include "boosting_functions_fast.h"
+#include "compact_data.h"
 
 #ifndef MAX
 #define MAX(a,b) ((a) < (b) ? (b) : (a)) // define MAX function for use later
@@ -13,6 +14,7 @@
 //' A fast implementation of the basic boosting function, giving predicted titres for a number of samples for one individual. Note that this version attempts to minimise memory allocations.
 //' @family boosting_functions
 //' @seealso \code{\link{titre_data_fast}}
+template <typename StrainIndices>
 void titre_data_fast_individual_base(NumericVector &predicted_titres,
 				     const double &mu,
 				     const double &mu_short,
@@ -20,7 +22,7 @@ void titre_data_fast_individual_base(NumericVector &predicted_titres,
 				     const double &tau,
 				     const NumericVector &infection_times,
 				     const IntegerVector &infection_strain_indices_tmp,
-				     const IntegerVector &measurement_strain_indices,
+				     const StrainIndices &measurement_strain_indices,
 				     const NumericVector &sample_times,
 				     const int &index_in_samples,
 				     const int &end_index_in_samples,
@@ -29,7 +31,7 @@ void titre_data_fast_individual_base(NumericVector &predicted_titres,
 				     const int &number_strains,
 				     const NumericVector &antigenic_map_short,
 				     const NumericVector &antigenic_map_long,
-				     bool boost_before_infection = false
+				     bool boost_before_infection
 				     ){
   double sampling_time;
   double time;
@@ -85,6 +87,7 @@ void titre_data_fast_individual_base(NumericVector &predicted_titres,
 //' A fast implementation of the alternative waning function, giving predicted titres for a number of samples for one individual. Note that this version attempts to minimise memory allocations.
 //' @family boosting_functions
 //' @seealso \code{\link{titre_data_fast}}
+template <typename StrainIndices>
 void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 				      const double &mu,
 				      const double &mu_short,
@@ -94,7 +97,7 @@ void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 				      const double &t_change,
 				      const NumericVector &infection_times,
 				      const IntegerVector &infection_strain_indices_tmp,
-				      const IntegerVector &measurement_strain_indices,
+				      const StrainIndices &measurement_strain_indices,
 				      const NumericVector &sample_times,
 				      const int &index_in_samples,
 				      const int &end_index_in_samples,
@@ -103,7 +106,7 @@ void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 				      const int &number_strains,
 				      const NumericVector &antigenic_map_short,
 				      const NumericVector &antigenic_map_long,
-				     bool boost_before_infection = false
+				     bool boost_before_infection
 				      ){
   double sampling_time;
   double time;
@@ -174,6 +177,7 @@ void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 //' A fast implementation of the titre dependent boosting function, giving predicted titres for a number of samples for one individual. Note that this version attempts to minimise memory allocations.
 //' @family boosting_functions
 //' @seealso \code{\link{titre_data_fast}}
+template <typename StrainIndices>
 void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 					 const double &mu,
 					 const double &mu_short,
@@ -183,7 +187,7 @@ void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 					 const double &boost_limit,
 					 const NumericVector &infection_times,
 					 const IntegerVector &infection_strain_indices_tmp,
-					 const IntegerVector &measurement_strain_indices,
+					 const StrainIndices &measurement_strain_indices,
 					 const NumericVector &sample_times,
 					 const int &index_in_samples,
 					 const int &end_index_in_samples,
@@ -192,7 +196,7 @@ void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 					 const int &number_strains,
 					 const NumericVector &antigenic_map_short,
 					 const NumericVector &antigenic_map_long,
-				     bool boost_before_infection = false
+				     bool boost_before_infection
 					 ){
   double sampling_time;
   double time;
@@ -302,6 +306,7 @@ void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 //' A fast implementation of the basic boosting function, giving predicted titres for a number of samples for one individual. Note that this version attempts to minimise memory allocations.
 //' @family boosting_functions
 //' @seealso \code{\link{titre_data_fast}}
+template <typename StrainIndices>
 void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres,
 						 const NumericVector &mus,
 						 const IntegerVector &boosting_vec_indices,
@@ -310,7 +315,7 @@ void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres
 						 const double &tau,
 						 const NumericVector &infection_times,
 						 const IntegerVector &infection_strain_indices_tmp,
-						 const IntegerVector &measurement_strain_indices,
+						 const StrainIndices &measurement_strain_indices,
 						 const NumericVector &sample_times,
 						 const int &index_in_samples,
 						 const int &end_index_in_samples,
@@ -319,7 +324,7 @@ void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres
 						 const int &number_strains,
 						 const NumericVector &antigenic_map_short,
 						 const NumericVector &antigenic_map_long,
-				     bool boost_before_infection = false
+				     bool boost_before_infection
 						 ){
   double sampling_time;
   double time;
@@ -372,3 +377,190 @@ void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres
     start_index_in_data = end_index_in_data;
   }
 }
+
+
+//' User-defined kinetics fast
+//' 
+//' Gives predicted titres for a number of samples for one individual, with boosting, waning and antigenic seniority given by expressions compiled by \code{\link{compile_kinetics}}. For each sample, each term is evaluated over all of the infections before that sample in one pass of the bytecode interpreter. Terms that do not depend on the time since infection are evaluated once for the individual, and each sample uses the values for the infections before it.
+//' @family boosting_functions
+//' @seealso \code{\link{titre_data_fast}}
+template <typename StrainIndices>
+void titre_data_fast_individual_kinetics(NumericVector &predicted_titres,
+					 kinetics_model &kinetics,
+					 const double &mu,
+					 const double &wane,
+					 const NumericVector &infection_times,
+					 const IntegerVector &infection_strain_indices_tmp,
+					 const StrainIndices &measurement_strain_indices,
+					 const NumericVector &sample_times,
+					 const int &index_in_samples,
+					 const int &end_index_in_samples,
+					 const int &start_index_in_data1,
+					 const IntegerVector &nrows_per_blood_sample,
+					 const int &number_strains,
+					 const NumericVector &antigenic_map_short,
+					 const NumericVector &antigenic_map_long,
+					 bool boost_before_infection
+					 ){
+  int max_infections = infection_times.size();
+  int start_index_in_data = start_index_in_data1;
+  int n_titres;
+  int n_active;
+  int inf_map_index;
+  int index;
+  double sampling_time;
+
+  std::vector<double> inf_time(infection_times.begin(), infection_times.end());
+  std::vector<double> n_inf(max_infections);
+  std::vector<double> time(max_infections);
+  for(int x = 0; x < max_infections; ++x) n_inf[x] = x + 1.0;
+
+  // Terms, and whether each has the same value for every infection
+  kinetics.set_individual(mu, wane);
+  kinetics_program *programs[4] = {&kinetics.boost, &kinetics.boost_short, &kinetics.waning, &kinetics.seniority};
+  std::vector<double> values[4];
+  bool scalar[4];
+  for(int p = 0; p < 4; ++p){
+    if(!programs[p]->time_dependent){
+      scalar[p] = kinetics.evaluate(*programs[p], max_infections, time.data(), n_inf.data(),
+				    inf_time.data(), 0, values[p]);
+    }
+  }
+
+  // For each sample this individual has
+  for(int j = index_in_samples; j <= end_index_in_samples; ++j){
+    sampling_time = sample_times[j];
+    n_titres = nrows_per_blood_sample[j];
+
+    // Infection times are in order, so the infections before this sample come first
+    n_active = 0;
+    while(n_active < max_infections &&
+	  ((boost_before_infection && sampling_time > inf_time[n_active]) ||
+	   (!boost_before_infection && sampling_time >= inf_time[n_active]))){
+      time[n_active] = sampling_time - inf_time[n_active];
+      ++n_active;
+    }
+    if(n_active > 0){
+      for(int p = 0; p < 4; ++p){
+	if(programs[p]->time_dependent){
+	  scalar[p] = kinetics.evaluate(*programs[p], n_active, time.data(), n_inf.data(),
+					inf_time.data(), sampling_time, values[p]);
+	}
+      }
+      const double *boost = values[0].data(), *boost_short = values[1].data();
+      const double *waning = values[2].data(), *seniority = values[3].data();
+      for(int x = 0; x < n_active; ++x){
+	double long_term = seniority[scalar[3] ? 0 : x]*boost[scalar[0] ? 0 : x];
+	double short_term = seniority[scalar[3] ? 0 : x]*boost_short[scalar[1] ? 0 : x]*waning[scalar[2] ? 0 : x];
+	inf_map_index = infection_strain_indices_tmp[x];
+	// Find contribution to each measured titre from this infection
+	for(int k = 0; k < n_titres; ++k){
+	  index = measurement_strain_indices[start_index_in_data + k]*number_strains + inf_map_index;
+	  predicted_titres[start_index_in_data + k] += long_term*antigenic_map_long[index] +
+	    short_term*antigenic_map_short[index];
+	}
+      }
+    }
+    start_index_in_data += n_titres;
+  }
+}
+
+//' Titres before each candidate infection time fast
+//' 
+//' Gives one individual's titre against the strain circulating at each candidate infection time, just before any infection at that time, under the base boosting and waning model (with optional strain-dependent boosting). Rather than solving the model once per candidate time as a separate sample, this steps forward through the candidate times once: infections are added to the running set, with their antigenic seniority, as the sweep passes them. Entries from first_time to last_time (indexed from 0) of row indiv of infection_time_titres are overwritten, so after a change to the infection history at time t, only the times after t need to be recomputed.
+//' @family boosting_functions
+//' @seealso \code{\link{titres_at_infection_times}}
+void infection_time_titres_individual(NumericMatrix &infection_time_titres,
+				      const int &indiv,
+				      const int &first_time,
+				      const int &last_time,
+				      const double &mu,
+				      const NumericVector &mus,
+				      const IntegerVector &boosting_vec_indices,
+				      const double &mu_short,
+				      const double &wane,
+				      const double &tau,
+				      const NumericVector &infection_times,
+				      const IntegerVector &infection_strain_indices_tmp,
+				      const NumericVector &circulation_times,
+				      const IntegerVector &circulation_times_indices,
+				      const int &number_strains,
+				      const NumericVector &antigenic_map_short,
+				      const NumericVector &antigenic_map_long
+				      ){
+  bool strain_dep_boost = mus.size() > 1;
+  int max_infections = infection_times.size();
+  int n_inf = 0; // Number of infections passed so far in the sweep
+  int inf_map_index;
+  int index;
+  int measured_strain;
+  double candidate_time;
+  double seniority;
+  double boost;
+  double titre;
+  // Seniority-weighted long and short term boosts of each infection already passed
+  std::vector<double> long_boosts(max_infections);
+  std::vector<double> short_boosts(max_infections);
+
+  for(int t = first_time; t <= last_time; ++t){
+    candidate_time = circulation_times[t];
+    measured_strain = circulation_times_indices[t];
+    // Add any infections that happened strictly before this candidate time
+    while(n_inf < max_infections && infection_times[n_inf] < candidate_time){
+      seniority = MAX(0, 1.0 - tau*n_inf); // Antigenic seniority
+      inf_map_index = infection_strain_indices_tmp[n_inf];
+      boost = strain_dep_boost ? mus[boosting_vec_indices[inf_map_index]] : mu;
+      long_boosts[n_inf] = seniority*boost;
+      short_boosts[n_inf] = seniority*mu_short;
+      ++n_inf;
+    }
+    titre = 0;
+    for(int x = 0; x < n_inf; ++x){
+      index = measured_strain*number_strains + infection_strain_indices_tmp[x];
+      titre += long_boosts[x]*antigenic_map_long[index] +
+	short_boosts[x]*antigenic_map_short[index]*MAX(0, 1.0 - wane*(candidate_time - infection_times[x]));
+    }
+    infection_time_titres(indiv, t) = titre;
+  }
+}
+
+
+// Explicit instantiations: the kernels read strain indices either from the IntegerVector
+// used by titre_data_fast, or directly from the packed observation records (see compact_data.h)
+#define INSTANTIATE_BOOSTING_KERNELS(STRAIN_INDICES)			\
+  template void titre_data_fast_individual_base<STRAIN_INDICES>(NumericVector&, \
+								const double&, const double&, const double&, const double&, \
+								const NumericVector&, const IntegerVector&, const STRAIN_INDICES&, \
+								const NumericVector&, const int&, const int&, const int&, \
+								const IntegerVector&, const int&, \
+								const NumericVector&, const NumericVector&, bool); \
+  template void titre_data_fast_individual_wane2<STRAIN_INDICES>(NumericVector&, \
+								 const double&, const double&, const double&, const double&, \
+								 const double&, const double&,	\
+								 const NumericVector&, const IntegerVector&, const STRAIN_INDICES&, \
+								 const NumericVector&, const int&, const int&, const int&, \
+								 const IntegerVector&, const int&, \
+								 const NumericVector&, const NumericVector&, bool); \
+  template void titre_data_fast_individual_titredep<STRAIN_INDICES>(NumericVector&, \
+								    const double&, const double&, const double&, const double&, \
+								    const double&, const double&, \
+								    const NumericVector&, const IntegerVector&, const STRAIN_INDICES&, \
+								    const NumericVector&, const int&, const int&, const int&, \
+								    const IntegerVector&, const int&, \
+								    const NumericVector&, const NumericVector&, bool); \
+  template void titre_data_fast_individual_strain_dependent<STRAIN_INDICES>(NumericVector&, \
+									    const NumericVector&, const IntegerVector&, \
+									    const double&, const double&, const double&, \
+									    const NumericVector&, const IntegerVector&, const STRAIN_INDICES&, \
+									    const NumericVector&, const int&, const int&, const int&, \
+									    const IntegerVector&, const int&, \
+									    const NumericVector&, const NumericVector&, bool); \
+  template void titre_data_fast_individual_kinetics<STRAIN_INDICES>(NumericVector&, kinetics_model&, \
+								    const double&, const double&, \
+								    const NumericVector&, const IntegerVector&, const STRAIN_INDICES&, \
+								    const NumericVector&, const int&, const int&, const int&, \
+								    const IntegerVector&, const int&, \
+								    const NumericVector&, const NumericVector&, bool);
+
+INSTANTIATE_BOOSTING_KERNELS(IntegerVector)
+INSTANTIATE_BOOSTING_KERNELS(packed_strain_indices)
@@ -1,14 +1,16 @@
 #include <Rcpp.h>
+#include "kinetics.h"
 using namespace Rcpp;
 
 #ifndef TITRE_DATA_FAST_INDIVIDUAL_BASE_H
 #define TITRE_DATA_FAST_INDIVIDUAL_BASE_H
+template <typename StrainIndices>
 void titre_data_fast_individual_base(NumericVector &predicted_titres,
 				     const double &mu, const double &mu_short, 
 				     const double &wane, const double &tau,
 				     const NumericVector &infection_times,
 				     const IntegerVector &infection_strain_indices_tmp,
-				     const IntegerVector &measurement_strain_indices,
+				     const StrainIndices &measurement_strain_indices,
 				     const NumericVector &sample_times,
 				     const int &index_in_samples,
 				     const int &end_index_in_samples,
@@ -24,6 +26,7 @@ void titre_data_fast_individual_base(NumericVector &predicted_titres,
 
 #ifndef TITRE_DATA_FAST_INDIVIDUAL_WANE2_H
 #define TITRE_DATA_FAST_INDIVIDUAL_WANE2_H
+template <typename StrainIndices>
 void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 				      const double &mu,
 				      const double &mu_short,
@@ -33,7 +36,7 @@ void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 				      const double &t_change,
 				      const NumericVector &infection_times,
 				      const IntegerVector &infection_strain_indices_tmp,
-				      const IntegerVector &measurement_strain_indices,
+				      const StrainIndices &measurement_strain_indices,
 				      const NumericVector &sample_times,
 				      const int &index_in_samples,
 				      const int &end_index_in_samples,
@@ -48,6 +51,7 @@ void titre_data_fast_individual_wane2(NumericVector &predicted_titres,
 
 #ifndef TITRE_DATA_FAST_INDIVIDUAL_TITREDEP_H
 #define TITRE_DATA_FAST_INDIVIDUAL_TITREDEP_H
+template <typename StrainIndices>
 void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 					   const double &mu,
 					   const double &mu_short,
@@ -57,7 +61,7 @@ void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 					   const double &boost_limit,
 					   const NumericVector &infection_times,
 					   const IntegerVector &infection_strain_indices_tmp,
-					   const IntegerVector &measurement_strain_indices,
+					   const StrainIndices &measurement_strain_indices,
 					   const NumericVector &sample_times,
 					   const int &index_in_samples,
 					   const int &end_index_in_samples,
@@ -72,6 +76,7 @@ void titre_data_fast_individual_titredep(NumericVector &predicted_titres,
 
 #ifndef TITRE_DATA_FAST_INDIVIDUAL_STRAIN_DEPENDENT_H
 #define TITRE_DATA_FAST_INDIVIDUAL_STRAIN_DEPENDENT_H
+template <typename StrainIndices>
 void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres,
 						 const NumericVector &mus,
 						 const IntegerVector &boosting_vec_indices,
@@ -80,7 +85,7 @@ void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres
 						 const double &tau,
 						 const NumericVector &infection_times,
 						 const IntegerVector &infection_strain_indices_tmp,
-						 const IntegerVector &measurement_strain_indices,
+						 const StrainIndices &measurement_strain_indices,
 						 const NumericVector &sample_times,
 						 const int &index_in_samples,
 						 const int &end_index_in_samples,
@@ -92,3 +97,47 @@ void titre_data_fast_individual_strain_dependent(NumericVector &predicted_titres
 						 bool boost_before_infection
 						 );
 #endif
+
+#ifndef TITRE_DATA_FAST_INDIVIDUAL_KINETICS_H
+#define TITRE_DATA_FAST_INDIVIDUAL_KINETICS_H
+template <typename StrainIndices>
+void titre_data_fast_individual_kinetics(NumericVector &predicted_titres,
+					 kinetics_model &kinetics,
+					 const double &mu,
+					 const double &wane,
+					 const NumericVector &infection_times,
+					 const IntegerVector &infection_strain_indices_tmp,
+					 const StrainIndices &measurement_strain_indices,
+					 const NumericVector &sample_times,
+					 const int &index_in_samples,
+					 const int &end_index_in_samples,
+					 const int &start_index_in_data1,
+					 const IntegerVector &nrows_per_blood_sample,
+					 const int &number_strains,
+					 const NumericVector &antigenic_map_short,
+					 const NumericVector &antigenic_map_long,
+					 bool boost_before_infection
+					 );
+#endif
+
+#ifndef INFECTION_TIME_TITRES_INDIVIDUAL_H
+#define INFECTION_TIME_TITRES_INDIVIDUAL_H
+void infection_time_titres_individual(NumericMatrix &infection_time_titres,
+				      const int &indiv,
+				      const int &first_time,
+				      const int &last_time,
+				      const double &mu,
+				      const NumericVector &mus,
+				      const IntegerVector &boosting_vec_indices,
+				      const double &mu_short,
+				      const double &wane,
+				      const double &tau,
+				      const NumericVector &infection_times,
+				      const IntegerVector &infection_strain_indices_tmp,
+				      const NumericVector &circulation_times,
+				      const IntegerVector &circulation_times_indices,
+				      const int &number_strains,
+				      const NumericVector &antigenic_map_short,
+				      const NumericVector &antigenic_map_long
+				      );
+#endif
@@ -0,0 +1,90 @@
+#include "compact_data.h"
+
+//' Pack unique titre data into compact records
+//'
+//' Interleaves the observed titres and the measured strain indices into one record of 4 bytes per observation: a 16-bit strain index, an 8-bit titre and one reserved byte. This is the layout read directly by the likelihood and boosting kernels during MCMC fitting, and takes a third of the memory of the separate double and integer vectors.
+//' @param titres NumericVector, the observed titres. These must be whole numbers between 0 and 255
+//' @param measurement_strain_indices IntegerVector, the index of each measured strain in the melted antigenic map, indexed from 0. These must be between 0 and 65535
+//' @return a RawVector of packed observations
+//' @family compact_data
+//' @export
+// [[Rcpp::export]]
+RawVector pack_titre_data(const NumericVector &titres, const IntegerVector &measurement_strain_indices){
+  int n_titres = titres.size();
+  if(measurement_strain_indices.size() != n_titres){
+    Rcpp::stop("titres and measurement_strain_indices must be the same length");
+  }
+  RawVector packed(n_titres * sizeof(packed_obs));
+  packed_obs *obs = reinterpret_cast<packed_obs*>(RAW(packed));
+  for(int i = 0; i < n_titres; ++i){
+    if(titres[i] < 0 || titres[i] > PACKED_MAX_TITRE || titres[i] != floor(titres[i])){
+      Rcpp::stop("Titre at row %i is not a whole number between 0 and %i", i + 1, PACKED_MAX_TITRE);
+    }
+    if(measurement_strain_indices[i] < 0 || measurement_strain_indices[i] > PACKED_MAX_INDEX){
+      Rcpp::stop("Strain index at row %i is not between 0 and %i", i + 1, PACKED_MAX_INDEX);
+    }
+    obs[i].index = measurement_strain_indices[i];
+    obs[i].titre = titres[i];
+    obs[i].reserved = 0;
+  }
+  return(packed);
+}
+
+//' Pack repeat titre data into compact records
+//'
+//' As \code{\link{pack_titre_data}}, but for the repeated titre measurements. Rather than the strain index, each record stores the row of the unique titre that the repeat corresponds to, as an offset from the first unique titre of that individual.
+//' @param repeat_titres NumericVector, the observed repeat titres
+//' @param repeat_indices IntegerVector, which entry in the unique titre data each repeat titre corresponds to, indexed from 0
+//' @param cum_nrows_per_individual_in_data IntegerVector, the cumulative number of unique titres for each individual, starting at 0
+//' @param cum_nrows_per_individual_in_repeat_data IntegerVector, the cumulative number of repeat titres for each individual, starting at 0
+//' @return a RawVector of packed observations
+//' @family compact_data
+//' @export
+// [[Rcpp::export]]
+RawVector pack_repeat_titre_data(const NumericVector &repeat_titres,
+				 const IntegerVector &repeat_indices,
+				 const IntegerVector &cum_nrows_per_individual_in_data,
+				 const IntegerVector &cum_nrows_per_individual_in_repeat_data){
+  int n_indivs = cum_nrows_per_individual_in_repeat_data.size() - 1;
+  int offset;
+  RawVector packed(repeat_titres.size() * sizeof(packed_obs));
+  packed_obs *obs = reinterpret_cast<packed_obs*>(RAW(packed));
+  for(int i = 0; i < n_indivs; ++i){
+    for(int x = cum_nrows_per_individual_in_repeat_data[i]; x < cum_nrows_per_individual_in_repeat_data[i+1]; ++x){
+      offset = repeat_indices[x] - cum_nrows_per_individual_in_data[i];
+      if(offset < 0 || offset > PACKED_MAX_INDEX){
+	Rcpp::stop("Repeat titre at row %i does not belong to individual %i", x + 1, i + 1);
+      }
+      if(repeat_titres[x] < 0 || repeat_titres[x] > PACKED_MAX_TITRE || repeat_titres[x] != floor(repeat_titres[x])){
+	Rcpp::stop("Repeat titre at row %i is not a whole number between 0 and %i", x + 1, PACKED_MAX_TITRE);
+      }
+      obs[x].index = offset;
+      obs[x].titre = repeat_titres[x];
+      obs[x].reserved = 0;
+    }
+  }
+  return(packed);
+}
+
+//' Unpack compact titre records
+//'
+//' Reverses \code{\link{pack_titre_data}} or \code{\link{pack_repeat_titre_data}}, giving back the titre and the stored index of each observation. The sampler reads the packed records directly, so this is only needed to check them, or for the rare setups that need the strain indices as a vector.
+//' @param packed RawVector, packed observations
+//' @return a list with titres, a NumericVector, and indices, an IntegerVector of the strain indices (for unique titres) or row offsets (for repeat titres)
+//' @family compact_data
+//' @export
+// [[Rcpp::export(rng = false)]]
+List unpack_titre_data(const RawVector &packed){
+  int n_obs = packed_obs_size(packed);
+  const packed_obs *obs = packed_obs_ptr(packed);
+  NumericVector titres(n_obs);
+  IntegerVector indices(n_obs);
+  for(int i = 0; i < n_obs; ++i){
+    titres[i] = obs[i].titre;
+    indices[i] = obs[i].index;
+  }
+  List ret;
+  ret["titres"] = titres;
+  ret["indices"] = indices;
+  return(ret);
+}
@@ -0,0 +1,48 @@
+#include <Rcpp.h>
+#include <cstdint>
+using namespace Rcpp;
+
+#ifndef COMPACT_DATA_H
+#define COMPACT_DATA_H
+
+// Largest values that fit into the packed observation record
+#define PACKED_MAX_TITRE 255
+#define PACKED_MAX_INDEX 65535
+
+// One observation of the preprocessed titre data, packed into 4 bytes rather than the
+// 12 bytes taken by a double titre plus an int strain index. For the unique titres,
+// index is the measured strain's index in the melted antigenic map. For the repeat
+// titres, index is the row offset from the start of that individual's unique titres.
+struct packed_obs {
+  uint16_t index;
+  uint8_t titre;
+  uint8_t reserved;
+};
+
+// Number of packed observations stored in a RawVector
+inline int packed_obs_size(const RawVector &packed){
+  return packed.size() / sizeof(packed_obs);
+}
+
+// Read-only pointer to the first packed observation of a RawVector
+inline const packed_obs* packed_obs_ptr(const RawVector &packed){
+  return reinterpret_cast<const packed_obs*>(RAW(packed));
+}
+
+// Exposes the strain indices of the packed unique titres with the same indexing as an
+// IntegerVector of measurement_strain_indices, so that the boosting kernels can read
+// the packed records directly
+class packed_strain_indices {
+ public:
+  packed_strain_indices(const RawVector &packed) : obs(packed_obs_ptr(packed)) {}
+  inline int operator[](const int &i) const { return obs[i].index; }
+ private:
+  const packed_obs *obs;
+};
+
+RawVector pack_titre_data(const NumericVector &titres, const IntegerVector &measurement_strain_indices);
+RawVector pack_repeat_titre_data(const NumericVector &repeat_titres,
+				 const IntegerVector &repeat_indices,
+				 const IntegerVector &cum_nrows_per_individual_in_data,
+				 const IntegerVector &cum_nrows_per_individual_in_repeat_data);
+#endif
@@ -0,0 +1,232 @@
+#include <Rcpp.h>
+#include <cmath>
+#include <vector>
+using namespace Rcpp;
+
+// Symmetric banded matrices are stored by rows of their lower band: entry (i, i - k), for
+// k = 0 to bandwidth, is at i*(bandwidth + 1) + k. The Cholesky factor of a banded matrix
+// has the same band, so is stored the same way
+struct banded_matrix {
+  int n;
+  int bandwidth;
+  std::vector<double> values;
+
+  banded_matrix(const int &n, const int &bandwidth)
+    : n(n), bandwidth(bandwidth), values((std::size_t)n*(bandwidth + 1), 0) {}
+  inline double &operator()(const int &i, const int &j){ return values[i*(bandwidth + 1) + i - j]; }
+  inline double operator()(const int &i, const int &j) const { return values[i*(bandwidth + 1) + i - j]; }
+};
+
+// Precision of a random walk of the given order on n points, R/rw_sd^2 + level_precision*I,
+// where R is D'D for the matrix D of differences of that order. The small diagonal term
+// makes the prior proper, as the random walk on its own says nothing about the level
+static banded_matrix rw_precision(const int &n, const int &order, const double &rw_sd,
+				  const double &level_precision){
+  std::vector<double> coefs(1, 1.0);
+  for(int k = 0; k < order; ++k){
+    std::vector<double> next(coefs.size() + 1, 0);
+    for(std::size_t c = 0; c < coefs.size(); ++c){
+      next[c] -= coefs[c];
+      next[c + 1] += coefs[c];
+    }
+    coefs = next;
+  }
+  banded_matrix Q(n, order);
+  double step_precision = 1.0/(rw_sd*rw_sd);
+  for(int r = 0; r + order < n; ++r){
+    for(int a = 0; a <= order; ++a){
+      for(int b = 0; b <= a; ++b){
+	Q(r + a, r + b) += step_precision*coefs[a]*coefs[b];
+      }
+    }
+  }
+  for(int i = 0; i < n; ++i) Q(i, i) += level_precision;
+  return(Q);
+}
+
+// Cholesky factor of a banded positive definite matrix, in O(n*bandwidth^2)
+static bool banded_cholesky(const banded_matrix &A, banded_matrix &L){
+  int p = A.bandwidth;
+  for(int j = 0; j < A.n; ++j){
+    double diag = A(j, j);
+    for(int k = std::max(0, j - p); k < j; ++k) diag -= L(j, k)*L(j, k);
+    if(!(diag > 0)) return false;
+    L(j, j) = std::sqrt(diag);
+    for(int i = j + 1; i <= std::min(A.n - 1, j + p); ++i){
+      double value = A(i, j);
+      for(int k = std::max(0, i - p); k < j; ++k) value -= L(i, k)*L(j, k);
+      L(i, j) = value/L(j, j);
+    }
+  }
+  return true;
+}
+
+// Solves L L' x = b in place
+static void banded_cholesky_solve(const banded_matrix &L, std::vector<double> &b){
+  int p = L.bandwidth;
+  for(int i = 0; i < L.n; ++i){
+    for(int k = std::max(0, i - p); k < i; ++k) b[i] -= L(i, k)*b[k];
+    b[i] /= L(i, i);
+  }
+  for(int i = L.n - 1; i >= 0; --i){
+    for(int k = i + 1; k <= std::min(L.n - 1, i + p); ++k) b[i] -= L(k, i)*b[k];
+    b[i] /= L(i, i);
+  }
+}
+
+// Solves L' x = b in place
+static void banded_cholesky_back_solve(const banded_matrix &L, std::vector<double> &b){
+  int p = L.bandwidth;
+  for(int i = L.n - 1; i >= 0; --i){
+    for(int k = i + 1; k <= std::min(L.n - 1, i + p); ++k) b[i] -= L(k, i)*b[k];
+    b[i] /= L(i, i);
+  }
+}
+
+static double banded_quad_form(const banded_matrix &A, const std::vector<double> &x){
+  double total = 0;
+  for(int i = 0; i < A.n; ++i){
+    total += A(i, i)*x[i]*x[i];
+    for(int k = std::max(0, i - A.bandwidth); k < i; ++k) total += 2*A(i, k)*x[i]*x[k];
+  }
+  return(total);
+}
+
+static double banded_log_det(const banded_matrix &L){
+  double total = 0;
+  for(int i = 0; i < L.n; ++i) total += 2*std::log(L(i, i));
+  return(total);
+}
+
+// log(1 + exp(x)) without overflow
+static inline double log1p_exp(const double &x){
+  return x > 0 ? x + std::log1p(std::exp(-x)) : std::log1p(std::exp(x));
+}
+
+// Binomial log likelihood of the infection counts, plus the random walk prior, on the logit scale
+static double phi_block_log_target(const std::vector<double> &x, const NumericVector &n_infections,
+				   const NumericVector &n_at_risk, const banded_matrix &Q){
+  double total = -0.5*banded_quad_form(Q, x);
+  for(int t = 0; t < Q.n; ++t) total += n_infections[t]*x[t] - n_at_risk[t]*log1p_exp(x[t]);
+  return(total);
+}
+
+//' Random walk prior on logit phi
+//'
+//' Log density of a Gaussian Markov random field prior on the logit of the per-time attack rates phi, where the logit attack rates follow a random walk of order rw_order with step standard deviation rw_sd. A normal prior with precision level_precision on each logit phi makes the prior proper. The precision matrix is banded, so its log determinant comes from a banded Cholesky factorisation in O(T) time.
+//' @param phis NumericVector, the attack rate at each time, between 0 and 1
+//' @param rw_sd double, the standard deviation of each step of the random walk
+//' @param rw_order int, 1 for a first order (random walk) or 2 for a second order (integrated random walk) prior
+//' @param level_precision double, the precision of the normal prior on each logit phi
+//' @return the log prior density of logit(phis)
+//' @family priors
+//' @export
+// [[Rcpp::export(rng = false)]]
+double phi_gmrf_log_prior(const NumericVector &phis, double rw_sd, int rw_order = 1,
+			  double level_precision = 0.01){
+  int n = phis.size();
+  banded_matrix Q = rw_precision(n, rw_order, rw_sd, level_precision);
+  banded_matrix L(n, rw_order);
+  if(!banded_cholesky(Q, L)) Rcpp::stop("Random walk precision matrix is not positive definite");
+  std::vector<double> x(n);
+  for(int t = 0; t < n; ++t) x[t] = std::log(phis[t]/(1 - phis[t]));
+  return(0.5*banded_log_det(L) - 0.5*banded_quad_form(Q, x) - 0.5*n*std::log(2*M_PI));
+}
+
+//' Block update of phi under a random walk prior
+//'
+//' Updates every per-time attack rate phi at once, under the random walk prior of \code{\link{phi_gmrf_log_prior}}. The conditional posterior of logit phi given the infection histories only depends on the number infected and the number at risk at each time, so the titre model is not needed. The proposal is the Laplace approximation to this conditional: the mode is found by Newton's method from the counts, and a draw is taken from the normal with the curvature at the mode as its precision. The precision is banded, so each Newton step and the draw use banded Cholesky solves, and the whole update is O(T). The proposal is accepted or rejected as an independence Metropolis-Hastings step, with any other prior on the phis from \code{log_prior} added to the acceptance ratio.
+//' @inheritParams phi_gmrf_log_prior
+//' @param n_infections NumericVector, the number of infections at each time
+//' @param n_at_risk NumericVector, the number of individuals that could be infected at each time
+//' @param log_prior (optional) a function of the vector of phis, giving any other log prior on them, eg. from CREATE_PRIOR_FUNC in \code{\link{run_MCMC}}. It is called on the current and the proposed phis
+//' @return a list with the updated phis, accepted (TRUE if the proposal was accepted) and mode, the attack rates at the mode of the Laplace approximation
+//' @family priors
+//' @export
+// [[Rcpp::export]]
+List phi_gmrf_block_update(const NumericVector &phis,
+			   const NumericVector &n_infections,
+			   const NumericVector &n_at_risk,
+			   double rw_sd,
+			   int rw_order = 1,
+			   double level_precision = 0.01,
+			   const Nullable<Function> &log_prior = R_NilValue){
+  int n = phis.size();
+  if(n_infections.size() != n || n_at_risk.size() != n){
+    Rcpp::stop("phis, n_infections and n_at_risk must have one entry per time");
+  }
+  banded_matrix Q = rw_precision(n, rw_order, rw_sd, level_precision);
+  banded_matrix P(n, rw_order);
+  banded_matrix L(n, rw_order);
+  std::vector<double> mode(n), step(n), current(n), proposal(n);
+  for(int t = 0; t < n; ++t){
+    current[t] = std::log(phis[t]/(1 - phis[t]));
+    // Start from the empirical attack rates, so the mode does not depend on the current phis
+    mode[t] = std::log((n_infections[t] + 0.5)/(n_at_risk[t] - n_infections[t] + 0.5));
+  }
+
+  // Newton's method. The Hessian of the negative log target is Q + diag(n p (1 - p))
+  for(int iter = 0; iter < 50; ++iter){
+    P.values = Q.values;
+    for(int t = 0; t < n; ++t){
+      double p = 1.0/(1.0 + std::exp(-mode[t]));
+      step[t] = n_infections[t] - n_at_risk[t]*p;
+      P(t, t) += n_at_risk[t]*p*(1 - p);
+    }
+    for(int i = 0; i < n; ++i){
+      step[i] -= Q(i, i)*mode[i];
+      for(int k = std::max(0, i - rw_order); k < i; ++k){
+	step[i] -= Q(i, k)*mode[k];
+	step[k] -= Q(i, k)*mode[i];
+      }
+    }
+    if(!banded_cholesky(P, L)) Rcpp::stop("Laplace approximation precision matrix is not positive definite");
+    banded_cholesky_solve(L, step);
+    double max_step = 0;
+    for(int t = 0; t < n; ++t){
+      mode[t] += step[t];
+      max_step = std::max(max_step, std::fabs(step[t]));
+    }
+    if(max_step < 1e-8) break;
+  }
+  // Curvature at the mode
+  P.values = Q.values;
+  for(int t = 0; t < n; ++t){
+    double p = 1.0/(1.0 + std::exp(-mode[t]));
+    P(t, t) += n_at_risk[t]*p*(1 - p);
+  }
+  banded_cholesky(P, L);
+
+  // Draw from N(mode, P^-1): solving L' y = z for standard normal z gives y with covariance P^-1
+  for(int t = 0; t < n; ++t) step[t] = R::norm_rand();
+  banded_cholesky_back_solve(L, step);
+  for(int t = 0; t < n; ++t) proposal[t] = mode[t] + step[t];
+
+  // Independence sampler: the proposal density at the current phis is needed as well
+  std::vector<double> current_offset(n);
+  for(int t = 0; t < n; ++t) current_offset[t] = current[t] - mode[t];
+  double log_q_proposal = -0.5*banded_quad_form(P, step);
+  double log_q_current = -0.5*banded_quad_form(P, current_offset);
+  double log_ratio = phi_block_log_target(proposal, n_infections, n_at_risk, Q) -
+    phi_block_log_target(current, n_infections, n_at_risk, Q) +
+    log_q_current - log_q_proposal;
+  if(log_prior.isNotNull()){
+    Function prior_func = as<Function>(log_prior);
+    NumericVector proposal_phis(n);
+    for(int t = 0; t < n; ++t) proposal_phis[t] = 1.0/(1.0 + std::exp(-proposal[t]));
+    log_ratio += as<double>(prior_func(proposal_phis)) - as<double>(prior_func(phis));
+  }
+  bool accepted = std::log(R::unif_rand()) < log_ratio;
+
+  NumericVector new_phis = clone(phis);
+  NumericVector mode_phis(n);
+  for(int t = 0; t < n; ++t){
+    if(accepted) new_phis[t] = 1.0/(1.0 + std::exp(-proposal[t]));
+    mode_phis[t] = 1.0/(1.0 + std::exp(-mode[t]));
+  }
+  List ret;
+  ret["phis"] = new_phis;
+  ret["accepted"] = accepted;
+  ret["mode"] = mode_phis;
+  return(ret);
+}
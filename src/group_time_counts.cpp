@@ -0,0 +1,301 @@
+#include "group_time_counts.h"
+#include <algorithm>
+
+group_time_counts::group_time_counts(const IntegerVector &age_mask,
+				     const IntegerVector &strain_mask,
+				     const IntegerVector &group_id_vec,
+				     const int &n_times,
+				     const Nullable<IntegerMatrix> &n_alive)
+  : n_groups(0), n_times(n_times), offsets(1, 0),
+    indiv_group(group_id_vec.begin(), group_id_vec.end()),
+    max_alive(0), prior_alpha(0), prior_beta(0), lbeta_const(0),
+    prior_set(false), log_prior_valid(false), log_prior_time(0) {
+  int n_indiv = group_id_vec.size();
+  int group;
+  if(age_mask.size() != n_indiv || strain_mask.size() != n_indiv){
+    Rcpp::stop("age_mask, strain_mask and group_id_vec must have one entry per individual");
+  }
+  IntegerMatrix n_alive_mat;
+  if(n_alive.isNotNull()){
+    n_alive_mat = IntegerMatrix(n_alive);
+    if(n_alive_mat.ncol() != n_times) Rcpp::stop("n_alive has %i columns, but there are %i times", n_alive_mat.ncol(), n_times);
+    n_groups = n_alive_mat.nrow();
+  }
+  for(int i = 0; i < n_indiv; ++i){
+    group = group_id_vec(i);
+    if(group < 0 || (n_alive.isNotNull() && group >= n_groups)){
+      Rcpp::stop("Individual %i has group %i, but there are only %i groups", i + 1, group + 1, n_groups);
+    }
+    n_groups = std::max(n_groups, group + 1);
+  }
+  first_time.assign(n_groups, n_times);
+  offsets.assign(n_groups + 1, 0);
+  alive_group.assign(n_groups, 0);
+  infections_group.assign(n_groups, 0);
+  std::vector<int> last_time(n_groups, -1);
+
+  // Each group spans every time that one of its members could be infected...
+  for(int i = 0; i < n_indiv; ++i){
+    group = group_id_vec(i);
+    first_time[group] = std::min(first_time[group], age_mask(i) - 1);
+    last_time[group] = std::max(last_time[group], strain_mask(i) - 1);
+  }
+  // ...and every time that n_alive says someone was alive, if it is given
+  if(n_alive.isNotNull()){
+    for(int g = 0; g < n_groups; ++g){
+      for(int t = 0; t < n_times; ++t){
+	if(n_alive_mat(g, t) > 0){
+	  first_time[g] = std::min(first_time[g], t);
+	  last_time[g] = std::max(last_time[g], t);
+	}
+      }
+    }
+  }
+  for(int g = 0; g < n_groups; ++g){
+    if(first_time[g] < 0 || last_time[g] >= n_times){
+      Rcpp::stop("Group %i has individuals who can be infected outside of the %i times", g + 1, n_times);
+    }
+    if(last_time[g] < first_time[g]) first_time[g] = last_time[g] + 1;
+    offsets[g + 1] = offsets[g] + last_time[g] - first_time[g] + 1;
+  }
+
+  alive.assign(offsets[n_groups], 0);
+  infections.assign(offsets[n_groups], 0);
+  if(n_alive.isNotNull()){
+    for(int g = 0; g < n_groups; ++g){
+      for(int i = offsets[g]; i < offsets[g + 1]; ++i) alive[i] = n_alive_mat(g, first_time[g] + i - offsets[g]);
+    }
+  } else {
+    // Each individual is alive from their age mask to their strain mask. Mark where
+    // they enter and leave their group's run, then take the running sum along each run
+    std::vector<int> changes(offsets[n_groups] + 1, 0);
+    for(int i = 0; i < n_indiv; ++i){
+      group = group_id_vec(i);
+      if(strain_mask(i) < age_mask(i)) continue;
+      changes[cell(group, age_mask(i) - 1)] += 1;
+      changes[cell(group, strain_mask(i) - 1) + 1] -= 1;
+    }
+    for(int g = 0; g < n_groups; ++g){
+      int running = 0;
+      for(int i = offsets[g]; i < offsets[g + 1]; ++i){
+	running += changes[i];
+	alive[i] = running;
+      }
+    }
+  }
+  for(int g = 0; g < n_groups; ++g){
+    for(int i = offsets[g]; i < offsets[g + 1]; ++i){
+      alive_group[g] += alive[i];
+      max_alive = std::max(max_alive, alive[i]);
+    }
+  }
+  // Prior version 4 looks up the prior on the total number alive in each group
+  for(int g = 0; g < n_groups; ++g) max_alive = std::max(max_alive, alive_group[g]);
+}
+
+// Each entry is the last plus one log, as lgamma(x + k + 1) = lgamma(x + k) + log(x + k),
+// so extending the tables to n costs n logs rather than a table of lbeta calls for each n
+void group_time_counts::extend_lookup(const int &n){
+  int k = log_rising_alpha_beta.size();
+  if(k == 0){
+    log_rising_alpha.push_back(0);
+    log_rising_beta.push_back(0);
+    log_rising_alpha_beta.push_back(0);
+    k = 1;
+  }
+  log_rising_alpha.resize(n + 1);
+  log_rising_beta.resize(n + 1);
+  log_rising_alpha_beta.resize(n + 1);
+  for(; k <= n; ++k){
+    log_rising_alpha[k] = log_rising_alpha[k - 1] + log(prior_alpha + k - 1);
+    log_rising_beta[k] = log_rising_beta[k - 1] + log(prior_beta + k - 1);
+    log_rising_alpha_beta[k] = log_rising_alpha_beta[k - 1] + log(prior_alpha + prior_beta + k - 1);
+  }
+}
+
+// Lookup tables and the running log prior only hold for one alpha and beta, so are
+// regenerated if these change. This costs O(largest number alive in a group),
+// so alpha and beta can be resampled without the table becoming the bottleneck
+void group_time_counts::set_prior(const double &alpha, const double &beta){
+  if(prior_set && alpha == prior_alpha && beta == prior_beta) return;
+  prior_alpha = alpha;
+  prior_beta = beta;
+  lbeta_const = R::lbeta(alpha, beta);
+  prior_set = true;
+  log_prior_valid = false;
+  log_rising_alpha.clear();
+  log_rising_beta.clear();
+  log_rising_alpha_beta.clear();
+  extend_lookup(max_alive);
+}
+
+void group_time_counts::add_infections(const int &group, const int &time, const int &change){
+  if(change == 0) return;
+  int i = cell(group, time);
+  if(i < 0){
+    Rcpp::stop("Infection added at time %i in group %i, where nobody is alive", time + 1, group + 1);
+  }
+  int m_old = infections[i];
+  int m_new = m_old + change;
+  infections[i] = m_new;
+  infections_group[group] += change;
+  if(log_prior_valid){
+    if(m_new < 0 || m_new > alive[i]){
+      // Leave the invalid count for log_prior to pick up
+      log_prior_valid = false;
+    } else if(alive[i] > 0){
+      log_prior_time += prior_lookup(alive[i], m_new) - prior_lookup(alive[i], m_old);
+    }
+  }
+}
+
+void group_time_counts::sync(const IntegerMatrix &infection_history_mat){
+  std::fill(infections.begin(), infections.end(), 0);
+  std::fill(infections_group.begin(), infections_group.end(), 0);
+  int n_indiv = infection_history_mat.nrow();
+  int group, j;
+  if(n_indiv != (int)indiv_group.size()){
+    Rcpp::stop("Infection history matrix has %i rows, but there are %i individuals", n_indiv, (int)indiv_group.size());
+  }
+  for(int t = 0; t < infection_history_mat.ncol(); ++t){
+    for(int i = 0; i < n_indiv; ++i){
+      if(infection_history_mat(i, t) == 0) continue;
+      group = indiv_group[i];
+      j = cell(group, t);
+      if(j < 0){
+	Rcpp::stop("Individual %i is infected at time %i, where nobody in their group is alive", i + 1, t + 1);
+      }
+      infections[j] += infection_history_mat(i, t);
+      infections_group[group] += infection_history_mat(i, t);
+    }
+  }
+  log_prior_valid = false;
+}
+
+double group_time_counts::log_prior(const double &alpha, const double &beta, const bool &prior_on_total){
+  set_prior(alpha, beta);
+  if(prior_on_total){
+    double lik = 0;
+    for(int g = 0; g < n_groups; ++g){
+      lik += R::lbeta(infections_group[g] + alpha, alive_group[g] - infections_group[g] + beta) - lbeta_const;
+    }
+    return(lik);
+  }
+  if(!log_prior_valid){
+    log_prior_time = 0;
+    for(size_t i = 0; i < alive.size(); ++i){
+      // Only solve if n > 0. Counts outside 0 to n are left to lbeta to give NaN
+      if(alive[i] > 0){
+	if(infections[i] >= 0 && infections[i] <= alive[i]){
+	  log_prior_time += prior_lookup(alive[i], infections[i]);
+	} else {
+	  log_prior_time += R::lbeta(infections[i] + alpha, alive[i] - infections[i] + beta) - lbeta_const;
+	}
+      }
+    }
+    log_prior_valid = true;
+  }
+  return(log_prior_time);
+}
+
+IntegerMatrix group_time_counts::dense_n_alive() const {
+  IntegerMatrix res(n_groups, n_times);
+  for(int g = 0; g < n_groups; ++g){
+    for(int i = offsets[g]; i < offsets[g + 1]; ++i) res(g, first_time[g] + i - offsets[g]) = alive[i];
+  }
+  return(res);
+}
+
+IntegerMatrix group_time_counts::dense_n_infections() const {
+  IntegerMatrix res(n_groups, n_times);
+  for(int g = 0; g < n_groups; ++g){
+    for(int i = offsets[g]; i < offsets[g + 1]; ++i) res(g, first_time[g] + i - offsets[g]) = infections[i];
+  }
+  return(res);
+}
+
+// Number infected at each time, summed over groups
+NumericVector group_time_counts::infections_by_time() const {
+  NumericVector res(n_times);
+  for(int g = 0; g < n_groups; ++g){
+    for(int i = offsets[g]; i < offsets[g + 1]; ++i) res[first_time[g] + i - offsets[g]] += infections[i];
+  }
+  return(res);
+}
+
+//' Create compressed group and time counts
+//'
+//' Builds the native store of the number of individuals alive and infected in each group and time that is used by the gibbs infection history sampler (prior versions 2 and 4). Each group only holds the times from the first to the last time that one of its members could be infected, and is counted straight from the masks, so the store stays small with many groups and no dense group by time matrix is needed. The returned object is updated in place by \code{\link{inf_hist_prop_prior_v2_and_v4}}, so is only rebuilt when the data change.
+//' @param age_mask IntegerVector, for each individual, the first time period that they can be infected (indexed from 1)
+//' @param strain_mask IntegerVector, for each individual, the last time period that they can be infected (indexed from 1)
+//' @param group_id_vec IntegerVector, the group of each individual, indexed from 0
+//' @param n_times int, the number of times at which individuals can be infected
+//' @param n_alive (optional) IntegerMatrix, the number of individuals alive in each group (rows) and time (columns), if this is known rather than given by the masks. If NULL, an individual is alive from their age mask to their strain mask
+//' @return an external pointer to the store. Infection counts are all 0 until \code{\link{group_time_counts_sync}} is called
+//' @family group_time_counts
+//' @export
+// [[Rcpp::export]]
+SEXP create_group_time_counts(const IntegerVector &age_mask, const IntegerVector &strain_mask,
+			      const IntegerVector &group_id_vec, int n_times,
+			      const Nullable<IntegerMatrix> &n_alive = R_NilValue){
+  Rcpp::XPtr<group_time_counts> counts(new group_time_counts(age_mask, strain_mask, group_id_vec, n_times, n_alive), true);
+  return(counts);
+}
+
+//' Recount infections in group and time counts
+//'
+//' Sets the infection counts of a store from \code{\link{create_group_time_counts}} from an infection history matrix. This is only needed when the infection histories have changed other than through \code{\link{inf_hist_prop_prior_v2_and_v4}}.
+//' @param group_counts the store returned by \code{\link{create_group_time_counts}}
+//' @param infection_history_mat IntegerMatrix, the infection history matrix
+//' @family group_time_counts
+//' @export
+// [[Rcpp::export]]
+void group_time_counts_sync(SEXP group_counts, const IntegerMatrix &infection_history_mat){
+  Rcpp::XPtr<group_time_counts> counts(group_counts);
+  counts->sync(infection_history_mat);
+}
+
+//' Infection history prior from group and time counts
+//'
+//' Marginal prior probability (p(Z)) of the infection histories held in a store from \code{\link{create_group_time_counts}}. Gives the same result as \code{\link{inf_mat_prior_group_cpp}} (or \code{\link{inf_mat_prior_total_group_cpp}} if \code{prior_on_total}), but the per-time prior is kept up to date as infections are added and removed, so is only recalculated in full when alpha or beta change.
+//' @param group_counts the store returned by \code{\link{create_group_time_counts}}
+//' @param alpha double, alpha parameter for beta distribution prior
+//' @param beta double, beta parameter for beta distribution prior
+//' @param prior_on_total bool, if TRUE, the prior is on the total number of infections in each group (prior version 4) rather than in each group and time
+//' @return a single prior probability
+//' @family group_time_counts
+//' @export
+// [[Rcpp::export]]
+double group_time_counts_log_prior(SEXP group_counts, double alpha, double beta, bool prior_on_total){
+  Rcpp::XPtr<group_time_counts> counts(group_counts);
+  return(counts->log_prior(alpha, beta, prior_on_total));
+}
+
+//' Dense matrices from group and time counts
+//'
+//' Expands a store from \code{\link{create_group_time_counts}} back into group by time matrices, eg. to check against \code{\link{sum_infections_by_group}}.
+//' @param group_counts the store returned by \code{\link{create_group_time_counts}}
+//' @return a list with the IntegerMatrix n_alive and the IntegerMatrix n_infections
+//' @family group_time_counts
+//' @export
+// [[Rcpp::export]]
+List group_time_counts_dense(SEXP group_counts){
+  Rcpp::XPtr<group_time_counts> counts(group_counts);
+  List ret;
+  ret["n_alive"] = counts->dense_n_alive();
+  ret["n_infections"] = counts->dense_n_infections();
+  return(ret);
+}
+
+//' Infections at each time from group and time counts
+//'
+//' Total number of infections at each time, summed over groups, from a store from \code{\link{create_group_time_counts}}. This only reads the store, so is much cheaper than \code{colSums} of the infection history matrix when there are many individuals.
+//' @param group_counts the store returned by \code{\link{create_group_time_counts}}
+//' @return NumericVector with the number of infections at each time
+//' @family group_time_counts
+//' @export
+// [[Rcpp::export]]
+NumericVector group_time_counts_infections_by_time(SEXP group_counts){
+  Rcpp::XPtr<group_time_counts> counts(group_counts);
+  return(counts->infections_by_time());
+}
@@ -0,0 +1,95 @@
+#include <Rcpp.h>
+#include <vector>
+using namespace Rcpp;
+
+#ifndef GROUP_TIME_COUNTS_H
+#define GROUP_TIME_COUNTS_H
+
+// Number alive and number infected in each group and time, for the beta-binomial
+// infection history prior. Rather than dense group by time matrices, each group only
+// stores the run of times from the first to the last time that anyone in it could be
+// infected, packed one after another as in a compressed sparse row matrix. With many
+// small groups (eg. villages by age band), most of the dense matrix would be zeros.
+// Infection counts are updated in place as the gibbs sampler accepts moves, and the
+// log prior is kept up to date alongside them, so neither has to be recounted from the
+// infection history matrix each iteration.
+class group_time_counts {
+ public:
+  group_time_counts(const IntegerVector &age_mask,
+		    const IntegerVector &strain_mask,
+		    const IntegerVector &group_id_vec,
+		    const int &n_times,
+		    const Nullable<IntegerMatrix> &n_alive);
+
+  int n_groups;
+  int n_times;
+
+  // Position of a group and time in the packed arrays, or -1 if nobody in the group
+  // is alive at that time
+  inline int cell(const int &group, const int &time) const {
+    int offset = time - first_time[group];
+    if(offset < 0 || offset >= offsets[group + 1] - offsets[group]) return -1;
+    return offsets[group] + offset;
+  }
+  inline int n_alive(const int &group, const int &time) const {
+    int i = cell(group, time);
+    return i < 0 ? 0 : alive[i];
+  }
+  inline int n_infections(const int &group, const int &time) const {
+    int i = cell(group, time);
+    return i < 0 ? 0 : infections[i];
+  }
+  inline int n_alive_group(const int &group) const { return alive_group[group]; }
+  inline int n_infections_group(const int &group) const { return infections_group[group]; }
+
+  // lbeta(m + alpha, n - m + beta) - lbeta(alpha, beta) for the current alpha and beta,
+  // from the rising factorials of alpha, beta and alpha + beta. The tables only go up to
+  // the largest n asked for since alpha and beta last changed. Counts outside 0 to n are
+  // left to lbeta, as in log_prior
+  inline double prior_lookup(const int &n, const int &m){
+    if(m < 0 || m > n) return R::lbeta(m + prior_alpha, n - m + prior_beta) - lbeta_const;
+    if(n >= (int)log_rising_alpha_beta.size()) extend_lookup(n);
+    return log_rising_alpha[m] + log_rising_beta[n - m] - log_rising_alpha_beta[n];
+  }
+
+  void set_prior(const double &alpha, const double &beta);
+  void add_infections(const int &group, const int &time, const int &change);
+  void sync(const IntegerMatrix &infection_history_mat);
+  double log_prior(const double &alpha, const double &beta, const bool &prior_on_total);
+  IntegerMatrix dense_n_alive() const;
+  IntegerMatrix dense_n_infections() const;
+  NumericVector infections_by_time() const;
+
+ private:
+  std::vector<int> first_time; // First time stored for each group
+  std::vector<int> offsets; // Start of each group in the packed arrays, with a final entry for the total
+  std::vector<int> indiv_group; // Group of each individual
+  std::vector<int> alive;
+  std::vector<int> infections;
+  std::vector<int> alive_group;
+  std::vector<int> infections_group;
+  int max_alive; // Largest number alive in any group and time, or in any group overall
+
+  double prior_alpha;
+  double prior_beta;
+  double lbeta_const;
+  bool prior_set;
+  bool log_prior_valid; // Is log_prior_time up to date with the counts?
+  double log_prior_time;
+  // log(x (x + 1) ... (x + k - 1)) = lgamma(x + k) - lgamma(x) for x = alpha, beta and
+  // alpha + beta, in entry k
+  std::vector<double> log_rising_alpha;
+  std::vector<double> log_rising_beta;
+  std::vector<double> log_rising_alpha_beta;
+
+  void extend_lookup(const int &n);
+};
+
+SEXP create_group_time_counts(const IntegerVector &age_mask, const IntegerVector &strain_mask,
+			      const IntegerVector &group_id_vec, int n_times,
+			      const Nullable<IntegerMatrix> &n_alive);
+void group_time_counts_sync(SEXP group_counts, const IntegerMatrix &infection_history_mat);
+double group_time_counts_log_prior(SEXP group_counts, double alpha, double beta, bool prior_on_total);
+List group_time_counts_dense(SEXP group_counts);
+NumericVector group_time_counts_infections_by_time(SEXP group_counts);
+#endif
@@ -2,29 +2,19 @@
 #include "wane_function.h"
 #include "boosting_functions_fast.h"
 #include "helpers.h"
+#include "compact_data.h"
+#include "likelihood_funcs.h"
 
-//' Overall model function, fast implementation
-//'
-//' @param theta NumericVector, the named vector of model parameters
-//' @param infection_history_mat IntegerMatrix, the matrix of 1s and 0s showing presence/absence of infection for each possible time for each individual. 
-//' @param circulation_times NumericVector, the actual times of circulation that the infection history vector corresponds to
-//' @param circulation_times_indices IntegerVector, which entry in the melted antigenic map that these infection times correspond to
-//' @param sample_times NumericVector, the times that each blood sample was taken
-//' @param rows_per_indiv_in_samples IntegerVector, one entry for each individual. Each entry dictates how many indices through sample_times to iterate per individual (ie. how many sample times does each individual have?)
-//' @param cum_nrows_per_individual_in_data IntegerVector, How many cumulative rows in the titre data correspond to each individual? 
-//' @param nrows_per_blood_sample IntegerVector, one entry per sample taken. Dictates how many entries to iterate through cum_nrows_per_individual_in_data for each sampling time considered
-//' @param measurement_strain_indices IntegerVector, the indices of all measured strains in the melted antigenic map, with one entry per measured titre
-//' @param antigenic_map_long NumericVector, the collapsed cross reactivity map for long term boosting, after multiplying by sigma1 see \code{\link{create_cross_reactivity_vector}}
-//' @param antigenic_map_short NumericVector, the collapsed cross reactivity map for short term boosting, after multiplying by sigma2, see \code{\link{create_cross_reactivity_vector}}
-//' @param antigenic_distances NumericVector, the collapsed cross reactivity map giving euclidean antigenic distances, see \code{\link{create_cross_reactivity_vector}}
-//' @param mus NumericVector, if length is greater than one, assumes that strain-specific boosting is used rather than a single boosting parameter
-//' @param boosting_vec_indices IntegerVector, same length as circulation_times, giving the index in the vector \code{mus} that each entry should use as its boosting parameter.
-//' @param boost_before_infection bool to indicate if calculated titre for that time should be before the infection has occurred, used to calculate titre-mediated immunity
-//' @return NumericVector of predicted titres for each entry in measurement_strain_indices
-//' @export
-//' @family titre_model
-// [[Rcpp::export(rng = false)]]
-NumericVector titre_data_fast(const NumericVector &theta, 
+// Called after each individual's titres are solved. Returning true stops the solve
+struct no_indiv_visitor {
+  inline bool operator()(const int &indiv, NumericVector &predicted_titres){ return false; }
+};
+
+// Shared implementation of titre_data_fast and titre_data_fast_packed, templated on how the
+// measured strain indices are stored. Individuals are solved in indiv_order (indexed from 0),
+// or in row order if indiv_order is empty
+template <typename StrainIndices, typename IndivVisitor>
+static NumericVector titre_data_fast_impl(const NumericVector &theta, 
 			      const IntegerMatrix &infection_history_mat, 
 			      const NumericVector &circulation_times,
 			      const IntegerVector &circulation_times_indices,
@@ -32,18 +22,22 @@ NumericVector titre_data_fast(const NumericVector &theta,
 			      const IntegerVector &rows_per_indiv_in_samples, // How many rows in titre data correspond to each individual, sample and repeat?
 			      const IntegerVector &cum_nrows_per_individual_in_data, // How many rows in the titre data correspond to each individual?
 			      const IntegerVector &nrows_per_blood_sample, // Split the sample times and runs for each individual
-			      const IntegerVector &measurement_strain_indices, // For each titre measurement, corresponding entry in antigenic map
+			      const StrainIndices &measurement_strain_indices, // For each titre measurement, corresponding entry in antigenic map
+			      const int &total_titres,
 			      const NumericVector &antigenic_map_long,
 			      const NumericVector &antigenic_map_short,
 			      const NumericVector &antigenic_distances,	// Currently not doing anything, but has uses for model extensions		      
 			      const NumericVector &mus,
 			      const IntegerVector &boosting_vec_indices,
-			      bool boost_before_infection = false
+			      const NumericMatrix &indiv_effects,
+			      bool boost_before_infection,
+			      const IntegerVector &indiv_order,
+			      const List &kinetics,
+			      IndivVisitor &visitor
 			      ){
   // Dimensions of structures
   int n = infection_history_mat.nrow();
   int number_strains = infection_history_mat.ncol();
-  int total_titres = measurement_strain_indices.size();
   
   // To track how far through the larger vectors we move for each individual
   int index_in_samples;
@@ -101,10 +95,22 @@ NumericVector titre_data_fast(const NumericVector &theta,
 			 titre_dependent_boosting ||
 			 strain_dep_boost);
 
+  // 4. Per-individual random effects on boosting and waning, on the log scale
+  bool use_indiv_effects = indiv_effects.nrow() == n;
+  double mu_indiv = mu;
+  double wane_indiv = wane;
+  NumericVector mus_indiv = clone(mus);
+
+  // 5. User-defined kinetics from compile_kinetics replace all of the above
+  kinetics_model kinetics_fns(kinetics, theta);
+
   // To store calculated titres
   NumericVector predicted_titres(total_titres, min_titre);
+  bool use_indiv_order = indiv_order.size() == n;
+  int i;
   // For each individual
-  for (int i = 1; i <= n; ++i) {
+  for (int k = 1; k <= n; ++k) {
+    i = use_indiv_order ? indiv_order[k-1] + 1 : k;
     infection_history = infection_history_mat(i-1,_);
     indices = infection_history > 0;
     infection_times = circulation_times[indices];
@@ -116,14 +122,37 @@ NumericVector titre_data_fast(const NumericVector &theta,
       end_index_in_samples = rows_per_indiv_in_samples[i] - 1;
       start_index_in_data = cum_nrows_per_individual_in_data[i-1];
 
+      if (use_indiv_effects) {
+	mu_indiv = mu*exp(indiv_effects(i-1,0));
+	wane_indiv = wane*exp(indiv_effects(i-1,1));
+	if (strain_dep_boost) {
+	  for (int k = 0; k < mus.size(); ++k) mus_indiv[k] = mus[k]*exp(indiv_effects(i-1,0));
+	}
+      }
+
       // ====================================================== //
       // =============== CHOOSE MODEL TO SOLVE =============== //
       // ====================================================== //
       // Go to sub function - this is where we have options for different models
       // Note, these are in "boosting_functions.cpp"
-      if (base_function) {
-	titre_data_fast_individual_base(predicted_titres, mu, mu_short,
-					wane, tau,
+      if (kinetics_fns.used) {
+	titre_data_fast_individual_kinetics(predicted_titres, kinetics_fns,
+					    mu_indiv, wane_indiv,
+					    infection_times,
+					    infection_strain_indices_tmp,
+					    measurement_strain_indices,
+					    sample_times,
+					    index_in_samples,
+					    end_index_in_samples,
+					    start_index_in_data,
+					    nrows_per_blood_sample,
+					    number_strains,
+					    antigenic_map_short,
+					    antigenic_map_long,
+					    boost_before_infection);
+      } else if (base_function) {
+	titre_data_fast_individual_base(predicted_titres, mu_indiv, mu_short,
+					wane_indiv, tau,
 					infection_times,
 					infection_strain_indices_tmp,
 					measurement_strain_indices,
@@ -137,8 +166,8 @@ NumericVector titre_data_fast(const NumericVector &theta,
 					antigenic_map_long,
 					boost_before_infection);
       } else if (titre_dependent_boosting) {
-	titre_data_fast_individual_titredep(predicted_titres, mu, mu_short,
-					    wane, tau,
+	titre_data_fast_individual_titredep(predicted_titres, mu_indiv, mu_short,
+					    wane_indiv, tau,
 					    gradient, boost_limit,
 					    infection_times,
 					    infection_strain_indices_tmp,
@@ -154,9 +183,9 @@ NumericVector titre_data_fast(const NumericVector &theta,
 					    boost_before_infection);	
       } else if (strain_dep_boost) {
 	titre_data_fast_individual_strain_dependent(predicted_titres, 
-						    mus, boosting_vec_indices, 
+						    mus_indiv, boosting_vec_indices, 
 						    mu_short,
-						    wane, tau,
+						    wane_indiv, tau,
 						    infection_times,
 						    infection_strain_indices_tmp,
 						    measurement_strain_indices,
@@ -170,8 +199,8 @@ NumericVector titre_data_fast(const NumericVector &theta,
 						    antigenic_map_long,
 						    boost_before_infection);
       } else if(alternative_wane_func) {
-	titre_data_fast_individual_wane2(predicted_titres, mu, mu_short,
-					 wane, tau,
+	titre_data_fast_individual_wane2(predicted_titres, mu_indiv, mu_short,
+					 wane_indiv, tau,
 					 kappa, t_change,
 					 infection_times,
 					 infection_strain_indices_tmp,
@@ -186,8 +215,8 @@ NumericVector titre_data_fast(const NumericVector &theta,
 					 antigenic_map_long,
 					 boost_before_infection);
       } else {
-	titre_data_fast_individual_base(predicted_titres, mu, mu_short,
-					wane, tau,
+	titre_data_fast_individual_base(predicted_titres, mu_indiv, mu_short,
+					wane_indiv, tau,
 					infection_times,
 					infection_strain_indices_tmp,
 					measurement_strain_indices,
@@ -203,6 +232,255 @@ NumericVector titre_data_fast(const NumericVector &theta,
       }
      
     }
+    if (visitor(i-1, predicted_titres)) break;
   }
   return(predicted_titres);
 }
+
+// Sums each individual's likelihood as soon as their titres are solved, and stops once the
+// running total falls below threshold. Each titre adds a log probability <= 0, so the total
+// can only fall as more individuals are added
+struct early_rejection_visitor {
+  const packed_obs *data;
+  const packed_obs *repeat_data;
+  const IntegerVector &cum_nrows_per_individual_in_data;
+  const IntegerVector &cum_nrows_per_individual_in_repeat_data;
+  const NumericVector &titre_shifts;
+  bool use_titre_shifts;
+  bool repeat_data_exist;
+  double log_const;
+  double den;
+  double max_titre;
+  double threshold;
+  double total;
+  NumericVector liks;
+
+  early_rejection_visitor(const NumericVector &theta,
+			  const RawVector &packed_titres,
+			  const RawVector &packed_repeat_titres,
+			  const IntegerVector &cum_nrows_per_individual_in_data,
+			  const IntegerVector &cum_nrows_per_individual_in_repeat_data,
+			  const NumericVector &titre_shifts,
+			  double threshold)
+    : data(packed_obs_ptr(packed_titres)), repeat_data(packed_obs_ptr(packed_repeat_titres)),
+      cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_data),
+      cum_nrows_per_individual_in_repeat_data(cum_nrows_per_individual_in_repeat_data),
+      titre_shifts(titre_shifts),
+      use_titre_shifts(titre_shifts.size() == packed_obs_size(packed_titres)),
+      repeat_data_exist(packed_obs_size(packed_repeat_titres) > 0),
+      log_const(log(0.5)), den(theta["error"]*M_SQRT2), max_titre(theta["MAX_TITRE"]),
+      threshold(threshold), total(0),
+      liks(cum_nrows_per_individual_in_data.size() - 1, R_NegInf) {}
+
+  inline bool operator()(const int &indiv, NumericVector &predicted_titres){
+    double lik = 0;
+    if(use_titre_shifts){
+      add_measurement_shifts(predicted_titres, titre_shifts,
+			     cum_nrows_per_individual_in_data[indiv],
+			     cum_nrows_per_individual_in_data[indiv+1] - 1);
+    }
+    proposal_likelihood_func(lik, predicted_titres, indiv, data, repeat_data,
+			     cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data,
+			     log_const, den, max_titre, repeat_data_exist, threshold - total);
+    liks[indiv] = lik;
+    total += lik;
+    return total < threshold;
+  }
+};
+
+//' Overall model function, fast implementation
+//'
+//' @param theta NumericVector, the named vector of model parameters
+//' @param infection_history_mat IntegerMatrix, the matrix of 1s and 0s showing presence/absence of infection for each possible time for each individual. 
+//' @param circulation_times NumericVector, the actual times of circulation that the infection history vector corresponds to
+//' @param circulation_times_indices IntegerVector, which entry in the melted antigenic map that these infection times correspond to
+//' @param sample_times NumericVector, the times that each blood sample was taken
+//' @param rows_per_indiv_in_samples IntegerVector, one entry for each individual. Each entry dictates how many indices through sample_times to iterate per individual (ie. how many sample times does each individual have?)
+//' @param cum_nrows_per_individual_in_data IntegerVector, How many cumulative rows in the titre data correspond to each individual? 
+//' @param nrows_per_blood_sample IntegerVector, one entry per sample taken. Dictates how many entries to iterate through cum_nrows_per_individual_in_data for each sampling time considered
+//' @param measurement_strain_indices IntegerVector, the indices of all measured strains in the melted antigenic map, with one entry per measured titre
+//' @param antigenic_map_long NumericVector, the collapsed cross reactivity map for long term boosting, after multiplying by sigma1 see \code{\link{create_cross_reactivity_vector}}
+//' @param antigenic_map_short NumericVector, the collapsed cross reactivity map for short term boosting, after multiplying by sigma2, see \code{\link{create_cross_reactivity_vector}}
+//' @param antigenic_distances NumericVector, the collapsed cross reactivity map giving euclidean antigenic distances, see \code{\link{create_cross_reactivity_vector}}
+//' @param mus NumericVector, if length is greater than one, assumes that strain-specific boosting is used rather than a single boosting parameter
+//' @param boosting_vec_indices IntegerVector, same length as circulation_times, giving the index in the vector \code{mus} that each entry should use as its boosting parameter.
+//' @param boost_before_infection bool to indicate if calculated titre for that time should be before the infection has occurred, used to calculate titre-mediated immunity
+//' @return NumericVector of predicted titres for each entry in measurement_strain_indices
+//' @export
+//' @family titre_model
+// [[Rcpp::export(rng = false)]]
+NumericVector titre_data_fast(const NumericVector &theta, 
+			      const IntegerMatrix &infection_history_mat, 
+			      const NumericVector &circulation_times,
+			      const IntegerVector &circulation_times_indices,
+			      const NumericVector &sample_times,
+			      const IntegerVector &rows_per_indiv_in_samples,
+			      const IntegerVector &cum_nrows_per_individual_in_data,
+			      const IntegerVector &nrows_per_blood_sample,
+			      const IntegerVector &measurement_strain_indices,
+			      const NumericVector &antigenic_map_long,
+			      const NumericVector &antigenic_map_short,
+			      const NumericVector &antigenic_distances,
+			      const NumericVector &mus,
+			      const IntegerVector &boosting_vec_indices,
+			      bool boost_before_infection = false
+			      ){
+  no_indiv_visitor visitor;
+  return(titre_data_fast_impl(theta, infection_history_mat, circulation_times, circulation_times_indices,
+			      sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data,
+			      nrows_per_blood_sample, measurement_strain_indices, measurement_strain_indices.size(),
+			      antigenic_map_long, antigenic_map_short, antigenic_distances,
+			      mus, boosting_vec_indices, NumericMatrix(0, 2), boost_before_infection,
+			      IntegerVector(0), List(0), visitor));
+}
+
+//' Overall model function, packed data implementation
+//'
+//' As \code{\link{titre_data_fast}}, but reads the measured strain indices directly from the packed observation records of \code{\link{pack_titre_data}}, rather than from a separate IntegerVector.
+//' @inheritParams titre_data_fast
+//' @param packed_titres RawVector, the packed unique titre data, see \code{\link{pack_titre_data}}
+//' @param indiv_effects NumericMatrix, per-individual random effects with one row per individual, giving the log-scale multipliers of mu (first column) and wane (second column). If the number of rows does not match the number of individuals, is not used.
+//' @param kinetics (optional) user-defined boosting, waning and seniority terms from \code{\link{compile_kinetics}}, which replace the built-in kinetics. Random effects then multiply any mu and wane used in the expressions
+//' @return NumericVector of predicted titres for each packed observation
+//' @export
+//' @family titre_model
+// [[Rcpp::export(rng = false)]]
+NumericVector titre_data_fast_packed(const NumericVector &theta, 
+				     const IntegerMatrix &infection_history_mat, 
+				     const NumericVector &circulation_times,
+				     const IntegerVector &circulation_times_indices,
+				     const NumericVector &sample_times,
+				     const IntegerVector &rows_per_indiv_in_samples,
+				     const IntegerVector &cum_nrows_per_individual_in_data,
+				     const IntegerVector &nrows_per_blood_sample,
+				     const RawVector &packed_titres,
+				     const NumericVector &antigenic_map_long,
+				     const NumericVector &antigenic_map_short,
+				     const NumericVector &antigenic_distances,
+				     const NumericVector &mus,
+				     const IntegerVector &boosting_vec_indices,
+				     const NumericMatrix &indiv_effects,
+				     bool boost_before_infection = false,
+				     const List &kinetics = R_NilValue
+				     ){
+  no_indiv_visitor visitor;
+  return(titre_data_fast_impl(theta, infection_history_mat, circulation_times, circulation_times_indices,
+			      sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data,
+			      nrows_per_blood_sample, packed_strain_indices(packed_titres), packed_obs_size(packed_titres),
+			      antigenic_map_long, antigenic_map_short, antigenic_distances,
+			      mus, boosting_vec_indices, indiv_effects, boost_before_infection,
+			      IntegerVector(0), kinetics, visitor));
+}
+
+//' Likelihood of each individual with early rejection
+//'
+//' Solves the model and the likelihood of each individual in turn, as \code{\link{titre_data_fast_packed}} followed by \code{\link{likelihood_func_fast_packed}}, but stops as soon as the summed likelihood falls below \code{threshold}. Each titre contributes a log probability of at most 0, so a partial sum is an upper bound on the full likelihood. If the MCMC acceptance threshold is known before the proposal is solved, most rejected proposals are found after solving only part of the cohort. Putting the individuals that contribute most to the likelihood first in \code{indiv_order} makes the bound fall fastest.
+//' @inheritParams titre_data_fast_packed
+//' @param cum_nrows_per_individual_in_repeat_data IntegerVector, the cumulative number of repeat titres for each individual, starting at 0
+//' @param packed_repeat_titres RawVector, the packed repeat titre data, see \code{\link{pack_repeat_titre_data}}. Length 0 if there are no repeats
+//' @param titre_shifts NumericVector, measurement bias added to each predicted titre. Not used unless it has one entry per packed titre
+//' @param indiv_order IntegerVector, the order (indexed from 0) to solve individuals in. Row order is used if this is not one entry per individual
+//' @param threshold double, the summed likelihood below which to stop
+//' @return a list with the NumericVector liks of likelihoods for each individual, and the bool rejected, which is TRUE if the solve stopped early. Individuals that were not reached have likelihood -Inf, and the last individual reached may have only an upper bound on their likelihood
+//' @export
+//' @family titre_model
+// [[Rcpp::export(rng = false)]]
+List likelihood_early_rejection_packed(const NumericVector &theta,
+				       const IntegerMatrix &infection_history_mat,
+				       const NumericVector &circulation_times,
+				       const IntegerVector &circulation_times_indices,
+				       const NumericVector &sample_times,
+				       const IntegerVector &rows_per_indiv_in_samples,
+				       const IntegerVector &cum_nrows_per_individual_in_data,
+				       const IntegerVector &cum_nrows_per_individual_in_repeat_data,
+				       const IntegerVector &nrows_per_blood_sample,
+				       const RawVector &packed_titres,
+				       const RawVector &packed_repeat_titres,
+				       const NumericVector &antigenic_map_long,
+				       const NumericVector &antigenic_map_short,
+				       const NumericVector &antigenic_distances,
+				       const NumericVector &mus,
+				       const IntegerVector &boosting_vec_indices,
+				       const NumericMatrix &indiv_effects,
+				       const NumericVector &titre_shifts,
+				       const IntegerVector &indiv_order,
+				       double threshold,
+				       const List &kinetics = R_NilValue
+				       ){
+  early_rejection_visitor visitor(theta, packed_titres, packed_repeat_titres,
+				  cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data,
+				  titre_shifts, threshold);
+  titre_data_fast_impl(theta, infection_history_mat, circulation_times, circulation_times_indices,
+		       sample_times, rows_per_indiv_in_samples, cum_nrows_per_individual_in_data,
+		       nrows_per_blood_sample, packed_strain_indices(packed_titres), packed_obs_size(packed_titres),
+		       antigenic_map_long, antigenic_map_short, antigenic_distances,
+		       mus, boosting_vec_indices, indiv_effects, false, indiv_order, kinetics, visitor);
+  List ret;
+  ret["liks"] = visitor.liks;
+  ret["rejected"] = visitor.total < threshold;
+  return(ret);
+}
+
+//' Titres before each candidate infection time
+//'
+//' For every individual and every time in which they could be infected, gives the titre against the strain circulating at that time just before any infection at that time. This is the quantity needed by titre-mediated protection models, and is found with one time-ordered sweep per individual (see \code{\link{infection_time_titres_individual}}), rather than by solving the model with one extra sample per candidate time. Only the base model and strain-dependent boosting are supported. No prior in the package uses these titres yet, so this is a building block for such models: \code{\link{run_MCMC}} does not compute them, but the gibbs sampler from \code{\link{create_posterior_func}} with \code{function_type = 2} keeps a matrix of them up to date if it is passed as \code{infection_time_titres}.
+//' @inheritParams titre_data_fast
+//' @param age_mask IntegerVector, for each individual, the first time period that they can be infected (indexed from 1)
+//' @param strain_mask IntegerVector, for each individual, the last time period that they can be infected (indexed from 1)
+//' @param indiv_effects NumericMatrix, per-individual random effects with one row per individual, giving the log-scale multipliers of mu (first column) and wane (second column). If the number of rows does not match the number of individuals, is not used.
+//' @return NumericMatrix with one row per individual and one column per time, giving the titre before infection at that time. Entries outside the age and strain masks are NA
+//' @export
+//' @family titre_model
+// [[Rcpp::export(rng = false)]]
+NumericMatrix titres_at_infection_times(const NumericVector &theta,
+					const IntegerMatrix &infection_history_mat,
+					const NumericVector &circulation_times,
+					const IntegerVector &circulation_times_indices,
+					const IntegerVector &age_mask,
+					const IntegerVector &strain_mask,
+					const NumericVector &antigenic_map_long,
+					const NumericVector &antigenic_map_short,
+					const NumericVector &mus,
+					const IntegerVector &boosting_vec_indices,
+					const NumericMatrix &indiv_effects
+					){
+  int n = infection_history_mat.nrow();
+  int number_strains = infection_history_mat.ncol();
+  if(theta["wane_type"] == 1 || theta["titre_dependent"] == 1){
+    Rcpp::stop("Titres at infection times are only available for the base model and strain-dependent boosting");
+  }
+  double mu = theta["mu"];
+  double mu_short = theta["mu_short"];
+  double wane = theta["wane"];
+  double tau = theta["tau"];
+
+  bool use_indiv_effects = indiv_effects.nrow() == n;
+  double mu_indiv = mu, wane_indiv = wane;
+  NumericVector mus_indiv = clone(mus);
+
+  IntegerVector infection_history(number_strains);
+  LogicalVector indices;
+  NumericVector infection_times;
+  IntegerVector infection_strain_indices_tmp;
+
+  NumericMatrix infection_time_titres(n, number_strains);
+  std::fill(infection_time_titres.begin(), infection_time_titres.end(), NA_REAL);
+
+  for(int i = 0; i < n; ++i){
+    if(use_indiv_effects){
+      mu_indiv = mu*exp(indiv_effects(i,0));
+      wane_indiv = wane*exp(indiv_effects(i,1));
+      for(int k = 0; k < mus.size(); ++k) mus_indiv[k] = mus[k]*exp(indiv_effects(i,0));
+    }
+    infection_history = infection_history_mat(i,_);
+    indices = infection_history > 0;
+    infection_times = circulation_times[indices];
+    infection_strain_indices_tmp = circulation_times_indices[indices];
+    infection_time_titres_individual(infection_time_titres, i, age_mask[i] - 1, strain_mask[i] - 1,
+				     mu_indiv, mus_indiv, boosting_vec_indices, mu_short, wane_indiv, tau,
+				     infection_times, infection_strain_indices_tmp,
+				     circulation_times, circulation_times_indices, number_strains,
+				     antigenic_map_short, antigenic_map_long);
+  }
+  return(infection_time_titres);
+}
@@ -0,0 +1,208 @@
+#include "kinetics.h"
+#include <algorithm>
+#include <cmath>
+
+kinetics_program::kinetics_program(const List &program)
+  : max_stack(as<int>(program["max_stack"])),
+    time_dependent(as<bool>(program["time_dependent"])) {
+  IntegerVector program_code = program["code"];
+  NumericVector program_constants = program["constants"];
+  code.assign(program_code.begin(), program_code.end());
+  constants.assign(program_constants.begin(), program_constants.end());
+}
+
+kinetics_model::kinetics_model(const List &kinetics, const NumericVector &theta)
+  : used(kinetics.size() > 0), mu_slot(-1), wane_slot(-1) {
+  if(!used) return;
+  boost = kinetics_program(as<List>(kinetics["boost"]));
+  boost_short = kinetics_program(as<List>(kinetics["boost_short"]));
+  waning = kinetics_program(as<List>(kinetics["waning"]));
+  seniority = kinetics_program(as<List>(kinetics["seniority"]));
+
+  // Parameters are looked up by name once per call, so the programs only hold indices.
+  // compile_kinetics has already checked that every name is in par_tab
+  CharacterVector par_names = kinetics["par_names"];
+  pars.resize(par_names.size());
+  for(int k = 0; k < par_names.size(); ++k){
+    std::string name = as<std::string>(par_names[k]);
+    pars[k] = theta[name];
+    if(name == "mu") mu_slot = k;
+    if(name == "wane") wane_slot = k;
+  }
+
+  int max_stack = std::max(std::max(boost.max_stack, boost_short.max_stack),
+			   std::max(waning.max_stack, seniority.max_stack));
+  stack.resize(max_stack);
+  stack_size.resize(max_stack);
+}
+
+void kinetics_model::set_individual(const double &mu, const double &wane){
+  if(mu_slot >= 0) pars[mu_slot] = mu;
+  if(wane_slot >= 0) pars[wane_slot] = wane;
+}
+
+// Applies op to each pair of a and b, recycling whichever has length one. The result
+// replaces a
+template <typename Op>
+static inline void kinetics_binary(std::vector<double> &a, int &a_size,
+				   const std::vector<double> &b, const int &b_size, Op op){
+  if(a_size == 1 && b_size == 1){
+    a[0] = op(a[0], b[0]);
+  } else if(a_size == 1){
+    double a0 = a[0];
+    for(int i = 0; i < b_size; ++i) a[i] = op(a0, b[i]);
+    a_size = b_size;
+  } else if(b_size == 1){
+    double b0 = b[0];
+    for(int i = 0; i < a_size; ++i) a[i] = op(a[i], b0);
+  } else {
+    for(int i = 0; i < a_size; ++i) a[i] = op(a[i], b[i]);
+  }
+}
+
+template <typename Op>
+static inline void kinetics_unary(std::vector<double> &a, const int &a_size, Op op){
+  for(int i = 0; i < a_size; ++i) a[i] = op(a[i]);
+}
+
+bool kinetics_model::evaluate(const kinetics_program &program, const int &n,
+			      const double *t, const double *n_inf,
+			      const double *inf_time, const double &sample_time,
+			      std::vector<double> &result){
+  int size_needed = std::max(n, 1);
+  for(int d = 0; d < program.max_stack; ++d){
+    if((int)stack[d].size() < size_needed) stack[d].resize(size_needed);
+  }
+  const int *code = program.code.data();
+  int code_size = program.code.size();
+  int top = -1;
+  int pc = 0;
+  while(pc < code_size){
+    int op = code[pc++];
+    switch(op){
+    case KIN_CONST:
+      ++top;
+      stack[top][0] = program.constants[code[pc++]];
+      stack_size[top] = 1;
+      break;
+    case KIN_PAR:
+      ++top;
+      stack[top][0] = pars[code[pc++]];
+      stack_size[top] = 1;
+      break;
+    case KIN_VAR: {
+      ++top;
+      int var = code[pc++];
+      if(var == KIN_VAR_SAMPLE_TIME){
+	stack[top][0] = sample_time;
+	stack_size[top] = 1;
+      } else {
+	const double *values = var == KIN_VAR_T ? t : (var == KIN_VAR_N ? n_inf : inf_time);
+	std::copy(values, values + n, stack[top].begin());
+	stack_size[top] = n;
+      }
+      break;
+    }
+    case KIN_ADD:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a + b; });
+      --top;
+      break;
+    case KIN_SUB:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a - b; });
+      --top;
+      break;
+    case KIN_MUL:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a*b; });
+      --top;
+      break;
+    case KIN_DIV:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a/b; });
+      --top;
+      break;
+    case KIN_POW:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return std::pow(a, b); });
+      --top;
+      break;
+    case KIN_MIN:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a < b ? a : b; });
+      --top;
+      break;
+    case KIN_MAX:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return a < b ? b : a; });
+      --top;
+      break;
+    case KIN_LT:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a < b); });
+      --top;
+      break;
+    case KIN_LE:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a <= b); });
+      --top;
+      break;
+    case KIN_GT:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a > b); });
+      --top;
+      break;
+    case KIN_GE:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a >= b); });
+      --top;
+      break;
+    case KIN_EQ:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a == b); });
+      --top;
+      break;
+    case KIN_NE:
+      kinetics_binary(stack[top - 1], stack_size[top - 1], stack[top], stack_size[top],
+		      [](double a, double b){ return (double)(a != b); });
+      --top;
+      break;
+    case KIN_NEG:
+      kinetics_unary(stack[top], stack_size[top], [](double a){ return -a; });
+      break;
+    case KIN_EXP:
+      kinetics_unary(stack[top], stack_size[top], [](double a){ return std::exp(a); });
+      break;
+    case KIN_LOG:
+      kinetics_unary(stack[top], stack_size[top], [](double a){ return std::log(a); });
+      break;
+    case KIN_SQRT:
+      kinetics_unary(stack[top], stack_size[top], [](double a){ return std::sqrt(a); });
+      break;
+    case KIN_ABS:
+      kinetics_unary(stack[top], stack_size[top], [](double a){ return std::fabs(a); });
+      break;
+    case KIN_IFELSE: {
+      // Condition, value if true and value if false, in push order
+      std::vector<double> &cond = stack[top - 2];
+      const std::vector<double> &yes = stack[top - 1];
+      const std::vector<double> &no = stack[top];
+      int size = std::max(stack_size[top - 2], std::max(stack_size[top - 1], stack_size[top]));
+      bool cond_vec = stack_size[top - 2] > 1, yes_vec = stack_size[top - 1] > 1, no_vec = stack_size[top] > 1;
+      double cond0 = cond[0];
+      for(int i = 0; i < size; ++i){
+	cond[i] = (cond_vec ? cond[i] : cond0) != 0 ? yes[yes_vec ? i : 0] : no[no_vec ? i : 0];
+      }
+      stack_size[top - 2] = size;
+      top -= 2;
+      break;
+    }
+    default:
+      Rcpp::stop("Unknown kinetics op code %i", op);
+    }
+  }
+  // Hand over the buffer rather than copying it. The stack gets the old result buffer back
+  std::swap(result, stack[0]);
+  return stack_size[0] == 1;
+}
@@ -0,0 +1,75 @@
+#include <Rcpp.h>
+#include <vector>
+using namespace Rcpp;
+
+#ifndef KINETICS_H
+#define KINETICS_H
+
+// Op codes of the postfix bytecode written by compile_kinetics in R. Push ops are followed
+// by one operand: the index of the constant, parameter or variable to push
+enum kinetics_op {
+  KIN_CONST = 0, KIN_PAR = 1, KIN_VAR = 2,
+  KIN_ADD = 10, KIN_SUB = 11, KIN_MUL = 12, KIN_DIV = 13, KIN_POW = 14, KIN_NEG = 15,
+  KIN_EXP = 20, KIN_LOG = 21, KIN_SQRT = 22, KIN_ABS = 23,
+  KIN_MIN = 30, KIN_MAX = 31,
+  KIN_LT = 40, KIN_LE = 41, KIN_GT = 42, KIN_GE = 43, KIN_EQ = 44, KIN_NE = 45,
+  KIN_IFELSE = 50
+};
+
+// Variables that an expression can refer to, one value per infection
+enum kinetics_var {
+  KIN_VAR_T = 0, // Time from infection to sample
+  KIN_VAR_N = 1, // Which infection this is, counting from 1
+  KIN_VAR_INF_TIME = 2,
+  KIN_VAR_SAMPLE_TIME = 3
+};
+
+// One compiled expression. Programs that do not use t or sample_time give the same values
+// for every sample, so only need evaluating once per individual
+struct kinetics_program {
+  std::vector<int> code;
+  std::vector<double> constants;
+  int max_stack;
+  bool time_dependent;
+
+  kinetics_program() : max_stack(0), time_dependent(false) {}
+  kinetics_program(const List &program);
+};
+
+// User-defined antibody kinetics. The titre against strain s from infection x is
+//   seniority[x]*(boost[x]*long(s, x) + boost_short[x]*short(s, x)*waning[x])
+// where each term is a compiled expression evaluated over all of an individual's
+// infections at once. The interpreter works on whole vectors, so the cost of dispatching
+// each op is shared by every infection, and terms that are the same for every infection
+// (eg. boost = mu) stay length one
+class kinetics_model {
+ public:
+  kinetics_model(const List &kinetics, const NumericVector &theta);
+
+  bool used; // FALSE if no kinetics were given, so the hard-coded kernels are used
+  kinetics_program boost;
+  kinetics_program boost_short;
+  kinetics_program waning;
+  kinetics_program seniority;
+
+  // Use these values of mu and wane for the next individual, for per-individual random effects
+  void set_individual(const double &mu, const double &wane);
+
+  // Evaluate a program over n infections, given the variables for each, into result.
+  // Returns TRUE if the result is the same for every infection, in which case only
+  // result[0] is set
+  bool evaluate(const kinetics_program &program, const int &n,
+		const double *t, const double *n_inf,
+		const double *inf_time, const double &sample_time,
+		std::vector<double> &result);
+
+ private:
+  std::vector<double> pars; // Value of each parameter the expressions refer to
+  int mu_slot; // Entries of pars holding mu and wane, or -1 if not used
+  int wane_slot;
+
+  // Evaluation stack, one buffer per depth
+  std::vector<std::vector<double> > stack;
+  std::vector<int> stack_size;
+};
+#endif
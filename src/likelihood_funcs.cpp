@@ -154,49 +154,106 @@ NumericVector likelihood_func_fast(const NumericVector &theta, const NumericVect
   return(ret);
 } 
 
+
+//' Fast observation error function, packed data
+//'  As \code{\link{likelihood_func_fast}}, but reads the observed titres from the packed records of \code{\link{pack_titre_data}} and sums the log likelihoods for each individual in the same pass, rather than returning one value per titre for \code{\link{sum_buckets}}.
+//' @inheritParams likelihood_func_fast
+//' @param packed_titres RawVector, the packed unique titre data
+//' @param cum_nrows_per_individual_in_data IntegerVector, the cumulative number of unique titres for each individual, starting at 0
+//' @return a likelihood for each individual
+//' @export
+//' @family likelihood_functions
+// [[Rcpp::export(rng = false)]]
+NumericVector likelihood_func_fast_packed(const NumericVector &theta, const RawVector &packed_titres, const NumericVector &predicted_titres,
+					  const IntegerVector &cum_nrows_per_individual_in_data){
+  int n_indivs = cum_nrows_per_individual_in_data.size() - 1;
+  NumericVector ret(n_indivs);
+  const packed_obs *obs = packed_obs_ptr(packed_titres);
+  const double sd = theta["error"];
+  const double den = sd*M_SQRT2;
+  const double max_titre = theta["MAX_TITRE"];
+  const double log_const = log(0.5);
+  double lik;
+
+  for(int i = 0; i < n_indivs; ++i){
+    lik = 0;
+    for(int x = cum_nrows_per_individual_in_data[i]; x < cum_nrows_per_individual_in_data[i+1]; ++x){
+      lik += packed_titre_log_lik(obs[x].titre, predicted_titres[x], den, max_titre, log_const);
+    }
+    ret[i] = lik;
+  }
+  return(ret);
+}
+
+//' Fast observation error function, packed repeat data
+//'  As \code{\link{likelihood_func_fast_packed}}, but for the repeated titre measurements packed by \code{\link{pack_repeat_titre_data}}. Each repeat is compared against the predicted titre of the unique titre it repeats, so the repeats need no predictions of their own.
+//' @inheritParams likelihood_func_fast_packed
+//' @param packed_repeat_titres RawVector, the packed repeat titre data
+//' @param cum_nrows_per_individual_in_repeat_data IntegerVector, the cumulative number of repeat titres for each individual, starting at 0
+//' @return a likelihood for each individual
+//' @export
+//' @family likelihood_functions
+// [[Rcpp::export(rng = false)]]
+NumericVector likelihood_func_fast_packed_repeats(const NumericVector &theta, const RawVector &packed_repeat_titres,
+						  const NumericVector &predicted_titres,
+						  const IntegerVector &cum_nrows_per_individual_in_data,
+						  const IntegerVector &cum_nrows_per_individual_in_repeat_data){
+  int n_indivs = cum_nrows_per_individual_in_repeat_data.size() - 1;
+  NumericVector ret(n_indivs);
+  const packed_obs *obs = packed_obs_ptr(packed_repeat_titres);
+  const double sd = theta["error"];
+  const double den = sd*M_SQRT2;
+  const double max_titre = theta["MAX_TITRE"];
+  const double log_const = log(0.5);
+  double lik;
+
+  for(int i = 0; i < n_indivs; ++i){
+    lik = 0;
+    for(int x = cum_nrows_per_individual_in_repeat_data[i]; x < cum_nrows_per_individual_in_repeat_data[i+1]; ++x){
+      lik += packed_titre_log_lik(obs[x].titre, predicted_titres[cum_nrows_per_individual_in_data[i] + obs[x].index],
+				  den, max_titre, log_const);
+    }
+    ret[i] = lik;
+  }
+  return(ret);
+}
+
 // Likelihood calculation for infection history proposal
 // Not really to be used elsewhere other than in \code{\link{inf_hist_prop_prior_v2_and_v4}}, as requires correct indexing for the predicted titres vector. Also, be very careful, as predicted_titres is set to 0 at the end!
+// Reads the observed titres directly from the packed records, see \code{\link{pack_titre_data}}
+// Every titre adds a log probability <= 0, so new_prob can only fall. If it falls below threshold,
+// the remaining titres are skipped and new_prob is left as an upper bound on the full likelihood
 void proposal_likelihood_func(double &new_prob,
 			      NumericVector &predicted_titres,
 			      const int &indiv,
-			      const NumericVector &data,
-			      const NumericVector &repeat_data,
-			      const IntegerVector &repeat_indices,
+			      const packed_obs *data,
+			      const packed_obs *repeat_data,
 			      const IntegerVector &cum_nrows_per_individual_in_data,
 			      const IntegerVector &cum_nrows_per_individual_in_repeat_data,
 			      const double &log_const,
 			      const double &den,
 			      const double &max_titre,
-			      const bool &repeat_data_exist){
-  for(int x = cum_nrows_per_individual_in_data[indiv]; x < cum_nrows_per_individual_in_data[indiv+1]; ++x){
-    if(data[x] < max_titre && data[x] >= 1.0){
-      new_prob += log_const + log((erf((data[x] + 1.0 - predicted_titres[x]) / den) -
-				   erf((data[x]     - predicted_titres[x]) / den)));    
-    } else if(data[x] >= max_titre) {
-      new_prob += log_const + log(erfc((max_titre - predicted_titres[x])/den));
-    } else {
-      new_prob += log_const + log(1.0 + erf((1.0 - predicted_titres[x])/den));
-    }
+			      const bool &repeat_data_exist,
+			      const double &threshold){
+  int start_index_in_data = cum_nrows_per_individual_in_data[indiv];
+  int x_pred;
+  for(int x = start_index_in_data; x < cum_nrows_per_individual_in_data[indiv+1]; ++x){
+    new_prob += packed_titre_log_lik(data[x].titre, predicted_titres[x], den, max_titre, log_const);
+    if(new_prob < threshold) break;
   }
 
   // =====================
   // Do something for repeat data here
-  if(repeat_data_exist){
+  // Repeat records store the row of their unique titre relative to the start of this individual
+  if(repeat_data_exist && !(new_prob < threshold)){
     for(int x = cum_nrows_per_individual_in_repeat_data[indiv]; x < cum_nrows_per_individual_in_repeat_data[indiv+1]; ++x){
-      if(repeat_data[x] < max_titre && repeat_data[x] >= 1.0){
-	new_prob += log_const + log((erf((repeat_data[x] + 1.0 - predicted_titres[repeat_indices[x]]) / den) -
-				     erf((repeat_data[x]     - predicted_titres[repeat_indices[x]]) / den)));    
-      } else if(repeat_data[x] >= max_titre) {
-	new_prob += log_const + log(erfc((max_titre - predicted_titres[repeat_indices[x]])/den));
-      } else {
-	new_prob += log_const + log(1.0 + erf((1.0 - predicted_titres[repeat_indices[x]])/den));
-      }
+      x_pred = start_index_in_data + repeat_data[x].index;
+      new_prob += packed_titre_log_lik(repeat_data[x].titre, predicted_titres[x_pred], den, max_titre, log_const);
+      if(new_prob < threshold) break;
     }
   }
   // Need to erase the predicted titre data...
-  for(int x = cum_nrows_per_individual_in_data[indiv]; x < cum_nrows_per_individual_in_data[indiv+1]; ++x){
+  for(int x = start_index_in_data; x < cum_nrows_per_individual_in_data[indiv+1]; ++x){
     predicted_titres[x] = 0;
   }
 }
-
-
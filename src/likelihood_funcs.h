@@ -1,18 +1,33 @@
 #include <Rcpp.h>
+#include "compact_data.h"
 using namespace Rcpp;
 
 #ifndef PROPOSAL_LIKELIHOOD_FUNC_H
 #define PROPOSAL_LIKELIHOOD_FUNC_H
+// Log likelihood of one observed titre given its predicted titre, for the discretised
+// normal observation model
+inline double packed_titre_log_lik(const double &obs, const double &predicted,
+				   const double &den, const double &max_titre,
+				   const double &log_const){
+  if(obs < max_titre && obs >= 1.0){
+    return log_const + log((erf((obs + 1.0 - predicted) / den) -
+			    erf((obs     - predicted) / den)));
+  } else if(obs >= max_titre) {
+    return log_const + log(erfc((max_titre - predicted)/den));
+  }
+  return log_const + log(1.0 + erf((1.0 - predicted)/den));
+}
+
 void proposal_likelihood_func(double &new_prob,
 			      NumericVector &predicted_titres,
 			      const int &indiv,
-			      const NumericVector &data,
-			      const NumericVector &repeat_data,
-			      const IntegerVector &repeat_indices,
+			      const packed_obs *data,
+			      const packed_obs *repeat_data,
 			      const IntegerVector &cum_nrows_per_individual_in_data,
 			      const IntegerVector &cum_nrows_per_individual_in_repeat_data,
 			      const double &log_const,
 			      const double &den,
 			      const double &max_titre,
-			      const bool &repeat_data_exist);
+			      const bool &repeat_data_exist,
+			      const double &threshold = R_NegInf);
 #endif
@@ -0,0 +1,595 @@
+#include <Rcpp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "compact_data.h"
+using namespace Rcpp;
+
+// Identifies a binary preprocessed titre dataset ("SSPD") and the layout version
+#define PREPROCESSED_MAGIC 0x44505353
+#define PREPROCESSED_VERSION 1
+// Number of records buffered from each sorted run during the merge
+#define MERGE_BUFFER_SIZE 4096
+// Maximum number of sorted runs opened at once during the merge
+#define MERGE_FAN_IN 64
+// Bytes copied at a time when assembling the output file
+#define COPY_BUFFER_SIZE 1048576
+
+// ============================================
+// One row of the titre data, as held during the external sort
+// ============================================
+struct titre_record {
+  double group;
+  double individual;
+  double samples;
+  double DOB;
+  int virus_index;
+  int run;
+  int titre;
+  int row;
+};
+
+// Sort order of the preprocessed data: group, individual, sample, virus and run. The
+// original row breaks ties so that the sort is stable across chunks
+static inline bool record_less(const titre_record &a, const titre_record &b){
+  if(a.group != b.group) return a.group < b.group;
+  if(a.individual != b.individual) return a.individual < b.individual;
+  if(a.samples != b.samples) return a.samples < b.samples;
+  if(a.virus_index != b.virus_index) return a.virus_index < b.virus_index;
+  if(a.run != b.run) return a.run < b.run;
+  return a.row < b.row;
+}
+
+// ============================================
+// File helpers
+// ============================================
+// Binary file handle which is closed when it goes out of scope, including when
+// Rcpp::stop unwinds the stack
+class binary_file {
+ public:
+  binary_file(const std::string &path, const char *mode) : f(std::fopen(path.c_str(), mode)), path(path) {
+    if(!f) Rcpp::stop("Could not open file %s", path);
+  }
+  ~binary_file(){ if(f) std::fclose(f); }
+  void write(const void *x, size_t size, size_t n){
+    if(n > 0 && std::fwrite(x, size, n, f) != n) Rcpp::stop("Could not write to file %s", path);
+  }
+  void read(void *x, size_t size, size_t n){
+    if(n > 0 && std::fread(x, size, n, f) != n) Rcpp::stop("File %s is truncated or corrupt", path);
+  }
+  size_t read_some(void *x, size_t size, size_t n){ return std::fread(x, size, n, f); }
+  void rewind(){ std::fflush(f); std::rewind(f); }
+  FILE *f;
+ private:
+  std::string path;
+  binary_file(const binary_file&);
+  binary_file& operator=(const binary_file&);
+};
+
+// Scratch files for the sorted runs and output sections, deleted when the ingest finishes or fails
+class scratch_files {
+ public:
+  scratch_files(const std::string &prefix) : prefix(prefix) {}
+  ~scratch_files(){
+    for(size_t i = 0; i < files.size(); ++i) std::remove(files[i].c_str());
+  }
+  std::string add(const std::string &name){
+    files.push_back(prefix + "_" + name + ".bin");
+    return files.back();
+  }
+ private:
+  std::string prefix;
+  std::vector<std::string> files;
+};
+
+// Appends the full contents of a scratch file to the output file
+static void append_file(binary_file &to, binary_file &from, std::vector<char> &buffer){
+  size_t n;
+  from.rewind();
+  while((n = from.read_some(buffer.data(), 1, buffer.size())) > 0){
+    to.write(buffer.data(), 1, n);
+  }
+}
+
+// ============================================
+// CSV parsing
+// ============================================
+// Splits one line of a csv file into its fields following RFC 4180: a field may be quoted,
+// in which case it can contain commas and doubled quotes. Whitespace and carriage returns
+// outside the quotes are stripped. Quoted fields spanning several lines are not supported
+static void split_csv_line(const std::string &line, std::vector<std::string> &fields, int line_no){
+  fields.clear();
+  std::string field;
+  size_t i = 0, n = line.size();
+  while(true){
+    field.clear();
+    while(i < n && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i;
+    if(i < n && line[i] == '"'){
+      // Quoted field, up to the closing quote
+      ++i;
+      while(true){
+	if(i >= n) Rcpp::stop("Line %i has an unterminated quoted field", line_no);
+	if(line[i] == '"'){
+	  if(i + 1 < n && line[i + 1] == '"'){
+	    field.push_back('"');
+	    i += 2;
+	  } else {
+	    ++i;
+	    break;
+	  }
+	} else {
+	  field.push_back(line[i++]);
+	}
+      }
+      while(i < n && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i;
+      if(i < n && line[i] != ',') Rcpp::stop("Line %i has text after a closing quote", line_no);
+    } else {
+      size_t end = line.find(',', i);
+      if(end == std::string::npos) end = n;
+      field = line.substr(i, end - i);
+      if(field.find('"') != std::string::npos) Rcpp::stop("Line %i has a quote inside an unquoted field", line_no);
+      size_t last = field.find_last_not_of(" \t\r");
+      field.erase(last == std::string::npos ? 0 : last + 1);
+      i = end;
+    }
+    fields.push_back(field);
+    if(i >= n) break;
+    ++i;
+  }
+}
+
+static bool is_missing(const std::string &field){
+  return field.empty() || field == "NA";
+}
+
+static double parse_number(const std::string &field, const char *column, int line){
+  char *end;
+  double x = std::strtod(field.c_str(), &end);
+  if(is_missing(field) || *end != '\0') Rcpp::stop("Line %i: column %s is not a number (\"%s\")", line, column, field);
+  return x;
+}
+
+// ============================================
+// Dataset builder
+// ============================================
+// Consumes the records in sorted order and writes the preprocessed dataset. Everything that
+// grows with the number of titres is streamed to scratch files; only per individual and per
+// group quantities are held in memory
+class dataset_builder {
+ public:
+  dataset_builder(const NumericVector &strain_isolation_times, scratch_files &scratch) :
+    times(strain_isolation_times.begin(), strain_isolation_times.end()),
+    unique_out(scratch.add("unique"), "w+b"),
+    repeat_out(scratch.add("repeats"), "w+b"),
+    overall_out(scratch.add("overall"), "w+b"),
+    sample_times_out(scratch.add("sample_times"), "w+b"),
+    sample_rows_out(scratch.add("sample_rows"), "w+b"),
+    n_rows(0), n_unique(0), n_repeats(0), n_samples(0), sample_rows(0), last_run(0) {
+    rows_per_indiv_in_samples.push_back(0);
+    cum_nrows_per_individual_in_data.push_back(0);
+    cum_nrows_per_individual_in_data_repeats.push_back(0);
+  }
+
+  void add(const titre_record &rec){
+    bool new_group = n_rows == 0 || rec.group != cur.group;
+    bool new_indiv = new_group || rec.individual != cur.individual;
+    bool new_sample = new_indiv || rec.samples != cur.samples;
+    bool new_obs = new_sample || rec.virus_index != cur.virus_index;
+    packed_obs obs;
+    int overall_index;
+
+    if(new_indiv){
+      if(n_rows > 0) close_individual();
+      if(new_group){
+	group_values.push_back(rec.group);
+	n_alive.push_back(std::vector<int>(times.size(), 0));
+      }
+      if(!seen_individuals.insert(rec.individual).second){
+	Rcpp::stop("Individual %.0f appears in more than one group", rec.individual);
+      }
+      max_sample = rec.samples;
+    } else if(!(rec.DOB == cur.DOB || (ISNAN(rec.DOB) && ISNAN(cur.DOB)))){
+      Rcpp::stop("Individual %.0f has more than one DOB", rec.individual);
+    }
+    if(new_sample && !new_indiv) close_sample();
+
+    if(new_obs){
+      if(rec.run != 1){
+	Rcpp::stop("Individual %.0f has a titre with run %i against virus %.0f at time %.0f, but no titre with run 1",
+		   rec.individual, rec.run, times[rec.virus_index], rec.samples);
+      }
+      obs.index = rec.virus_index;
+      obs.titre = rec.titre;
+      obs.reserved = 0;
+      unique_out.write(&obs, sizeof(packed_obs), 1);
+      ++n_unique;
+      ++sample_rows;
+    } else {
+      if(rec.run == last_run){
+	Rcpp::stop("Individual %.0f has more than one titre with run %i against virus %.0f at time %.0f",
+		   rec.individual, rec.run, times[rec.virus_index], rec.samples);
+      }
+      int offset = n_unique - 1 - cum_nrows_per_individual_in_data.back();
+      if(offset > PACKED_MAX_INDEX){
+	Rcpp::stop("Individual %.0f has more than %i unique titres", rec.individual, PACKED_MAX_INDEX);
+      }
+      obs.index = offset;
+      obs.titre = rec.titre;
+      obs.reserved = 0;
+      repeat_out.write(&obs, sizeof(packed_obs), 1);
+      ++n_repeats;
+    }
+    overall_index = n_unique - 1;
+    overall_out.write(&overall_index, sizeof(int), 1);
+
+    max_sample = std::max(max_sample, rec.samples);
+    last_run = rec.run;
+    cur = rec;
+    ++n_rows;
+  }
+
+  // Closes the last individual and writes the dataset to output_file
+  List finish(const std::string &output_file){
+    if(n_rows == 0) Rcpp::stop("The titre data has no rows");
+    close_individual();
+
+    int n_indiv = individual_ids.size();
+    int n_groups = group_values.size();
+    int n_times = times.size();
+    int header[9] = {PREPROCESSED_MAGIC, PREPROCESSED_VERSION, n_times, n_indiv, n_groups,
+		     n_samples, n_unique, n_repeats, n_rows};
+    std::vector<int> n_alive_long(n_groups * n_times);
+    for(int t = 0; t < n_times; ++t){
+      for(int g = 0; g < n_groups; ++g){
+	n_alive_long[t * n_groups + g] = n_alive[g][t];
+      }
+    }
+    std::vector<char> buffer(COPY_BUFFER_SIZE);
+    {
+      binary_file out(output_file, "wb");
+      out.write(header, sizeof(int), 9);
+      out.write(times.data(), sizeof(double), n_times);
+      out.write(group_values.data(), sizeof(double), n_groups);
+      out.write(individual_ids.data(), sizeof(double), n_indiv);
+      out.write(group_id_vec.data(), sizeof(int), n_indiv);
+      out.write(DOBs.data(), sizeof(double), n_indiv);
+      out.write(age_mask.data(), sizeof(int), n_indiv);
+      out.write(strain_mask.data(), sizeof(int), n_indiv);
+      out.write(rows_per_indiv_in_samples.data(), sizeof(int), n_indiv + 1);
+      out.write(cum_nrows_per_individual_in_data.data(), sizeof(int), n_indiv + 1);
+      out.write(cum_nrows_per_individual_in_data_repeats.data(), sizeof(int), n_indiv + 1);
+      out.write(n_alive_long.data(), sizeof(int), n_groups * n_times);
+      append_file(out, sample_times_out, buffer);
+      append_file(out, sample_rows_out, buffer);
+      append_file(out, unique_out, buffer);
+      append_file(out, repeat_out, buffer);
+      append_file(out, overall_out, buffer);
+    }
+    return(List::create(Named("n_rows") = n_rows,
+			Named("n_unique") = n_unique,
+			Named("n_repeats") = n_repeats,
+			Named("n_samples") = n_samples,
+			Named("n_indiv") = n_indiv,
+			Named("n_groups") = n_groups));
+  }
+
+ private:
+  void close_sample(){
+    sample_times_out.write(&cur.samples, sizeof(double), 1);
+    sample_rows_out.write(&sample_rows, sizeof(int), 1);
+    sample_rows = 0;
+    ++n_samples;
+  }
+
+  // Records the per individual quantities and masks of the current individual, matching
+  // create_age_mask, create_strain_mask and get_n_alive_group
+  void close_individual(){
+    int n_times = times.size();
+    int first = -1, last = -1;
+    close_sample();
+    for(int t = 0; t < n_times; ++t){
+      if(first < 0 && (ISNAN(cur.DOB) || cur.DOB <= times[t])) first = t;
+      if(max_sample >= times[t]) last = t;
+    }
+    if(first < 0) Rcpp::stop("Individual %.0f was born after the last possible infection time", cur.individual);
+    if(last < 0) Rcpp::stop("Individual %.0f was sampled before the first possible infection time", cur.individual);
+    for(int t = first; t <= last; ++t) ++n_alive[group_values.size() - 1][t];
+
+    individual_ids.push_back(cur.individual);
+    group_id_vec.push_back(group_values.size() - 1);
+    DOBs.push_back(cur.DOB);
+    age_mask.push_back(first + 1);
+    strain_mask.push_back(last + 1);
+    rows_per_indiv_in_samples.push_back(n_samples);
+    cum_nrows_per_individual_in_data.push_back(n_unique);
+    cum_nrows_per_individual_in_data_repeats.push_back(n_repeats);
+  }
+
+  std::vector<double> times;
+  binary_file unique_out, repeat_out, overall_out, sample_times_out, sample_rows_out;
+  int n_rows, n_unique, n_repeats, n_samples, sample_rows, last_run;
+  double max_sample;
+  titre_record cur;
+  std::unordered_set<double> seen_individuals;
+  std::vector<double> group_values, individual_ids, DOBs;
+  std::vector<std::vector<int> > n_alive;
+  std::vector<int> group_id_vec, age_mask, strain_mask;
+  std::vector<int> rows_per_indiv_in_samples, cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_data_repeats;
+};
+
+// ============================================
+// External merge of the sorted runs
+// ============================================
+class run_merger {
+ public:
+  run_merger(const std::vector<std::string> &run_files) : sources(run_files.size()) {
+    for(size_t i = 0; i < run_files.size(); ++i){
+      sources[i].f = new binary_file(run_files[i], "rb");
+      sources[i].buffer.resize(MERGE_BUFFER_SIZE);
+      sources[i].pos = sources[i].n = 0;
+      titre_record rec;
+      if(next(i, rec)) heap.push(std::make_pair(rec, i));
+    }
+  }
+  ~run_merger(){
+    for(size_t i = 0; i < sources.size(); ++i) delete sources[i].f;
+  }
+  bool pop(titre_record &rec){
+    if(heap.empty()) return false;
+    size_t i = heap.top().second;
+    rec = heap.top().first;
+    heap.pop();
+    titre_record next_rec;
+    if(next(i, next_rec)) heap.push(std::make_pair(next_rec, i));
+    return true;
+  }
+
+ private:
+  struct source {
+    binary_file *f;
+    std::vector<titre_record> buffer;
+    size_t pos, n;
+  };
+  struct heap_greater {
+    bool operator()(const std::pair<titre_record, size_t> &a, const std::pair<titre_record, size_t> &b) const {
+      return record_less(b.first, a.first);
+    }
+  };
+  bool next(size_t i, titre_record &rec){
+    source &s = sources[i];
+    if(s.pos == s.n){
+      s.n = s.f->read_some(s.buffer.data(), sizeof(titre_record), s.buffer.size());
+      s.pos = 0;
+      if(s.n == 0) return false;
+    }
+    rec = s.buffer[s.pos++];
+    return true;
+  }
+  std::vector<source> sources;
+  std::priority_queue<std::pair<titre_record, size_t>, std::vector<std::pair<titre_record, size_t> >, heap_greater> heap;
+};
+
+// Merges groups of at most MERGE_FAN_IN sorted runs into longer runs, over as many passes
+// as needed, until the remaining runs can all be opened for the final merge
+static void merge_runs(std::vector<std::string> &run_files, scratch_files &scratch){
+  std::vector<titre_record> buffer;
+  titre_record rec;
+  int pass = 0;
+  while(run_files.size() > MERGE_FAN_IN){
+    std::vector<std::string> merged;
+    buffer.reserve(MERGE_BUFFER_SIZE);
+    for(size_t start = 0; start < run_files.size(); start += MERGE_FAN_IN){
+      size_t end = std::min(start + MERGE_FAN_IN, run_files.size());
+      std::vector<std::string> group(run_files.begin() + start, run_files.begin() + end);
+      if(group.size() == 1){
+	merged.push_back(group[0]);
+	continue;
+      }
+      merged.push_back(scratch.add("merge" + std::to_string(pass) + "_" + std::to_string(merged.size())));
+      {
+	binary_file out(merged.back(), "wb");
+	run_merger merger(group);
+	buffer.clear();
+	while(merger.pop(rec)){
+	  buffer.push_back(rec);
+	  if(buffer.size() == MERGE_BUFFER_SIZE){
+	    out.write(buffer.data(), sizeof(titre_record), buffer.size());
+	    buffer.clear();
+	  }
+	}
+	out.write(buffer.data(), sizeof(titre_record), buffer.size());
+      }
+      // The merged runs are no longer needed, so free their disk space now
+      for(size_t i = 0; i < group.size(); ++i) std::remove(group[i].c_str());
+      Rcpp::checkUserInterrupt();
+    }
+    run_files.swap(merged);
+    ++pass;
+  }
+}
+
+//' Stream titre data from a csv file into a preprocessed dataset
+//'
+//' Reads the titre csv file in chunks of \code{chunk_size} rows, validates each row, sorts each chunk and spills it to a scratch file, then merges the sorted chunks by group, individual, sample time, virus and run, opening at most 64 chunks at once and merging over several passes if there are more. Fields may be quoted as in RFC 4180. The merged rows are written straight into the binary preprocessed dataset, together with the age mask, strain mask and number alive per group, so that memory use is bounded by the chunk size and the number of individuals rather than the number of titres. Use \code{\link{preprocess_titre_csv}} rather than calling this directly.
+//' @param csv_file the csv file of titre data, with columns individual, samples, virus and titre, and optionally group, run and DOB
+//' @param output_file the file to write the preprocessed dataset to
+//' @param strain_isolation_times NumericVector, the times at which individuals can be infected, in the order of the antigenic map
+//' @param chunk_size int, the number of rows to hold in memory at once
+//' @param scratch_prefix the path prefix for scratch files
+//' @return a list giving the number of rows, unique titres, repeat titres, samples, individuals and groups written
+//' @family preprocess_data
+// [[Rcpp::export(rng = false)]]
+List stream_preprocess_titre_csv(const std::string &csv_file,
+				 const std::string &output_file,
+				 const NumericVector &strain_isolation_times,
+				 const int &chunk_size,
+				 const std::string &scratch_prefix){
+  if(chunk_size < 1) Rcpp::stop("chunk_size must be at least 1");
+  std::ifstream in(csv_file.c_str());
+  if(!in) Rcpp::stop("Could not open file %s", csv_file);
+
+  // Find the columns
+  std::string line;
+  std::vector<std::string> fields;
+  if(!std::getline(in, line)) Rcpp::stop("File %s is empty", csv_file);
+  split_csv_line(line, fields, 1);
+  const char *col_names[7] = {"individual", "samples", "virus", "titre", "group", "run", "DOB"};
+  int cols[7];
+  for(int c = 0; c < 7; ++c){
+    cols[c] = std::find(fields.begin(), fields.end(), col_names[c]) - fields.begin();
+    if(cols[c] == (int)fields.size()) cols[c] = -1;
+  }
+  for(int c = 0; c < 4; ++c){
+    if(cols[c] < 0) Rcpp::stop("The following column is missing from data: %s", col_names[c]);
+  }
+  int n_cols = fields.size();
+
+  if(strain_isolation_times.size() == 0 || strain_isolation_times.size() - 1 > PACKED_MAX_INDEX){
+    Rcpp::stop("There must be between 1 and %i strain isolation times", PACKED_MAX_INDEX + 1);
+  }
+  // First index of each strain isolation time, as match() would give
+  std::unordered_map<double, int> virus_indices;
+  for(int i = strain_isolation_times.size() - 1; i >= 0; --i){
+    virus_indices[strain_isolation_times[i]] = i;
+  }
+  double min_time = *std::min_element(strain_isolation_times.begin(), strain_isolation_times.end());
+
+  // Read, validate and sort each chunk, spilling it to a run file
+  scratch_files scratch(scratch_prefix);
+  std::vector<std::string> run_files;
+  std::vector<titre_record> chunk;
+  chunk.reserve(chunk_size);
+  titre_record rec;
+  int line_no = 1, row = 0;
+  bool more = true;
+  while(more){
+    chunk.clear();
+    while((int)chunk.size() < chunk_size && (more = (bool)std::getline(in, line))){
+      ++line_no;
+      if(line.find_first_not_of(" \t\r") == std::string::npos) continue;
+      split_csv_line(line, fields, line_no);
+      if((int)fields.size() != n_cols) Rcpp::stop("Line %i has %i fields, expected %i", line_no, (int)fields.size(), n_cols);
+
+      rec.individual = parse_number(fields[cols[0]], "individual", line_no);
+      rec.samples = parse_number(fields[cols[1]], "samples", line_no);
+      double virus = parse_number(fields[cols[2]], "virus", line_no);
+      double titre = parse_number(fields[cols[3]], "titre", line_no);
+      rec.group = cols[4] < 0 ? 1 : parse_number(fields[cols[4]], "group", line_no);
+      rec.run = cols[5] < 0 ? 1 : parse_number(fields[cols[5]], "run", line_no);
+      if(cols[6] < 0){
+	rec.DOB = min_time;
+      } else {
+	rec.DOB = is_missing(fields[cols[6]]) ? NA_REAL : parse_number(fields[cols[6]], "DOB", line_no);
+      }
+      std::unordered_map<double, int>::const_iterator it = virus_indices.find(virus);
+      if(it == virus_indices.end()) Rcpp::stop("Line %i: virus %.0f is not one of the strain isolation times", line_no, virus);
+      if(titre < 0 || titre > PACKED_MAX_TITRE || titre != std::floor(titre)){
+	Rcpp::stop("Line %i: titre is not a whole number between 0 and %i", line_no, PACKED_MAX_TITRE);
+      }
+      rec.virus_index = it->second;
+      rec.titre = titre;
+      rec.row = row++;
+      chunk.push_back(rec);
+    }
+    if(chunk.size() > 0){
+      std::sort(chunk.begin(), chunk.end(), record_less);
+      run_files.push_back(scratch.add("run" + std::to_string(run_files.size())));
+      binary_file run_out(run_files.back(), "wb");
+      run_out.write(chunk.data(), sizeof(titre_record), chunk.size());
+    }
+    Rcpp::checkUserInterrupt();
+  }
+  std::vector<titre_record>().swap(chunk);
+
+  // Merge the runs straight into the output sections
+  merge_runs(run_files, scratch);
+  dataset_builder builder(strain_isolation_times, scratch);
+  {
+    run_merger merger(run_files);
+    while(merger.pop(rec)){
+      builder.add(rec);
+    }
+  }
+  return(builder.finish(output_file));
+}
+
+//' Read a preprocessed titre dataset
+//'
+//' Reads the binary dataset written by \code{\link{stream_preprocess_titre_csv}}. Use \code{\link{load_preprocessed_titre_data}} rather than calling this directly.
+//' @param file the preprocessed dataset file
+//' @return a list with the strain isolation times, the per individual, per sample and per titre vectors used by \code{\link{create_posterior_func}}, the masks and the number alive in each group at each time
+//' @family preprocess_data
+// [[Rcpp::export(rng = false)]]
+List read_preprocessed_titre_data(const std::string &file){
+  binary_file in(file, "rb");
+  int header[9];
+  in.read(header, sizeof(int), 9);
+  if(header[0] != PREPROCESSED_MAGIC) Rcpp::stop("%s is not a preprocessed titre dataset", file);
+  if(header[1] != PREPROCESSED_VERSION) Rcpp::stop("%s was written by an incompatible version of serosolver", file);
+  int n_times = header[2], n_indiv = header[3], n_groups = header[4], n_samples = header[5];
+  int n_unique = header[6], n_repeats = header[7], n_rows = header[8];
+
+  NumericVector strain_isolation_times(n_times), group_values(n_groups), individual_ids(n_indiv), DOBs(n_indiv);
+  IntegerVector group_id_vec(n_indiv), age_mask(n_indiv), strain_mask(n_indiv);
+  IntegerVector rows_per_indiv_in_samples(n_indiv + 1), cum_nrows_per_individual_in_data(n_indiv + 1);
+  IntegerVector cum_nrows_per_individual_in_data_repeats(n_indiv + 1);
+  IntegerMatrix n_alive(n_groups, n_times);
+  NumericVector sample_times(n_samples);
+  IntegerVector nrows_per_blood_sample(n_samples), overall_indices(n_rows);
+  RawVector packed_titres(n_unique * sizeof(packed_obs)), packed_repeat_titres(n_repeats * sizeof(packed_obs));
+
+  in.read(REAL(strain_isolation_times), sizeof(double), n_times);
+  in.read(REAL(group_values), sizeof(double), n_groups);
+  in.read(REAL(individual_ids), sizeof(double), n_indiv);
+  in.read(INTEGER(group_id_vec), sizeof(int), n_indiv);
+  in.read(REAL(DOBs), sizeof(double), n_indiv);
+  in.read(INTEGER(age_mask), sizeof(int), n_indiv);
+  in.read(INTEGER(strain_mask), sizeof(int), n_indiv);
+  in.read(INTEGER(rows_per_indiv_in_samples), sizeof(int), n_indiv + 1);
+  in.read(INTEGER(cum_nrows_per_individual_in_data), sizeof(int), n_indiv + 1);
+  in.read(INTEGER(cum_nrows_per_individual_in_data_repeats), sizeof(int), n_indiv + 1);
+  in.read(INTEGER(n_alive), sizeof(int), n_groups * n_times);
+  in.read(REAL(sample_times), sizeof(double), n_samples);
+  in.read(INTEGER(nrows_per_blood_sample), sizeof(int), n_samples);
+  in.read(RAW(packed_titres), sizeof(packed_obs), n_unique);
+  in.read(RAW(packed_repeat_titres), sizeof(packed_obs), n_repeats);
+  in.read(INTEGER(overall_indices), sizeof(int), n_rows);
+
+  // The titres stay packed. Only the per-individual counts are unpacked for the R side
+  IntegerVector nrows_per_individual_in_data(n_indiv), nrows_per_individual_in_data_repeats(n_indiv);
+  for(int i = 0; i < n_indiv; ++i){
+    nrows_per_individual_in_data[i] = cum_nrows_per_individual_in_data[i + 1] - cum_nrows_per_individual_in_data[i];
+    nrows_per_individual_in_data_repeats[i] = cum_nrows_per_individual_in_data_repeats[i + 1] - cum_nrows_per_individual_in_data_repeats[i];
+  }
+  for(int x = 0; x < n_rows; ++x) overall_indices[x] += 1;
+
+  List out;
+  out.push_back(strain_isolation_times, "strain_isolation_times");
+  out.push_back(n_indiv, "n_indiv");
+  out.push_back(individual_ids, "individual_ids");
+  out.push_back(group_values, "group_values");
+  out.push_back(group_id_vec, "group_id_vec");
+  out.push_back(DOBs, "DOBs");
+  out.push_back(age_mask, "age_mask");
+  out.push_back(strain_mask, "strain_mask");
+  out.push_back(n_alive, "n_alive");
+  out.push_back(sample_times, "sample_times");
+  out.push_back(rows_per_indiv_in_samples, "rows_per_indiv_in_samples");
+  out.push_back(nrows_per_blood_sample, "nrows_per_blood_sample");
+  out.push_back(nrows_per_individual_in_data, "nrows_per_individual_in_data");
+  out.push_back(cum_nrows_per_individual_in_data, "cum_nrows_per_individual_in_data");
+  out.push_back(packed_titres, "packed_titres");
+  out.push_back(nrows_per_individual_in_data_repeats, "nrows_per_individual_in_data_repeats");
+  out.push_back(cum_nrows_per_individual_in_data_repeats, "cum_nrows_per_individual_in_data_repeats");
+  out.push_back(packed_repeat_titres, "packed_repeat_titres");
+  out.push_back(overall_indices, "overall_indices");
+  return(out);
+}
@@ -2,6 +2,7 @@
 #include "boosting_functions_fast.h"
 #include "likelihood_funcs.h"
 #include "helpers.h"
+#include "group_time_counts.h"
 // [[Rcpp::depends(RcppArmadillo)]]
 
 //' Fast infection history proposal function
@@ -123,10 +124,8 @@ arma::mat inf_hist_prop_prior_v3(arma::mat infection_history_mat,
 //' @param n_years_samp_vec int, for each individual, how many time periods to resample infections for?
 //' @param age_mask IntegerVector, length of the number of individuals, with indices specifying first time period that an individual can be infected (indexed from 1, such that a value of 1 allows an individual to be infected in any time period)
 //' @param strain_mask IntegerVector, length of the number of individuals, with indices specifying last time period that an individual can be infected (ie. last time a sample was taken)
-//' @param n_alive IntegerMatrix, number of columns is the number of time periods that an individual could be infected, giving the number of individual alive in each time period. Number of rows is the number of distinct groups.
-//' @param n_infections IntegerMatrix, the number of infections in each year (columns) for each group (rows)
-//' @param n_infected_group IntegerVector, the total number of infections across all times in each group
-//' @param prior_lookup NumericMatrix, the pre-computed lookup table for the beta prior on infection histories
+//' @param group_counts the number alive and infected in each group and time, from \code{\link{create_group_time_counts}}. This must match infection_history_mat, and the infection counts are updated in place as proposals are accepted
+//' @param prior_on_total bool, if TRUE, uses prior version 4 (prior on the total number of infections in each group) rather than prior version 2
 //' @param swap_propn double, gives the proportion of proposals that will be swap steps (ie. swap contents of two cells in infection_history rather than adding/removing infections)
 //' @param swap_distance int, in a swap step, how many time steps either side of the chosen time period to swap with
 //' @param alpha double, alpha parameter for beta prior on infection probability
@@ -139,24 +138,28 @@ arma::mat inf_hist_prop_prior_v3(arma::mat infection_history_mat,
 //' @param cum_nrows_per_individual_in_repeat_data IntegerVector, For the repeat data (ie. already calculated these titres), how many rows in the titre data correspond to each individual?
 //' @param nrows_per_blood_sample IntegerVector, Split the sample times and runs for each individual
 //' @param group_id_vec IntegerVector, vector with 1 entry per individual, giving the group ID of that individual
-//' @param measurement_strain_indices IntegerVector, For each titre measurement, corresponding entry in antigenic map
 //' @param antigenic_map_long NumericVector, the collapsed cross reactivity map for long term boosting, after multiplying by sigma1, see \code{\link{create_cross_reactivity_vector}}
 //' @param antigenic_map_short NumericVector, the collapsed cross reactivity map for short term boosting, after multiplying by sigma2, see \code{\link{create_cross_reactivity_vector}}
 //' @param antigenic_distances NumericVector matching the dimensions of antigenic_map_long and antigenic_map_short, but with the raw antigenic distances between strains
-//' @param data NumericVector, data for all individuals for the first instance of each calculated titre
-//' @param repeat_data NumericVector, the repeat titre data for all individuals (ie. do not solve the same titres twice)
-//' @param repeat_indices IntegerVector, which index in the main data vector does each entry in repeat_data correspond to ie. which calculated titre in predicted_titres should be used for each observation?
-//' @param titre_shifts NumericVector, if length matches the length of \code{data}, adds these as measurement shifts to the predicted titres. If lengths do not match, is not used.
+//' @param packed_titres RawVector, the packed data for all individuals for the first instance of each calculated titre, giving the observed titre and the corresponding entry in the antigenic map for each titre measurement. See \code{\link{pack_titre_data}}
+//' @param packed_repeat_titres RawVector, the packed repeat titre data for all individuals (ie. do not solve the same titres twice), giving which calculated titre in predicted_titres should be used for each observation. See \code{\link{pack_repeat_titre_data}}. Length 0 if there are no repeats.
+//' @param titre_shifts NumericVector, if length matches the number of titres in \code{packed_titres}, adds these as measurement shifts to the predicted titres. If lengths do not match, is not used.
 //' @param proposal_iter IntegerVector, vector with entry for each individual, storing the number of infection history add/remove proposals for each individual.
 //' @param accepted_iter IntegerVector, vector with entry for each individual, storing the number of accepted infection history add/remove proposals for each individual.
 //' @param proposal_swap IntegerVector, vector with entry for each individual, storing the number of proposed infection history swaps
 //' @param accepted_swap IntegerVector, vector with entry for each individual, storing the number of accepted infection history swaps
 //' @param mus NumericVector, if length is greater than one, assumes that strain-specific boosting is used rather than a single boosting parameter
 //' @param boosting_vec_indices IntegerVector, same length as circulation_times, giving the index in the vector \code{mus} that each entry should use as its boosting parameter.
-//' @param total_alive IntegerVector, giving the total number of potential infection events for each group. This only applies to prior version 4. If set to a vector of values -1, then this is ignored.
+//' @param indiv_effects NumericMatrix, per-individual random effects with one row per individual, giving the log-scale multipliers of mu (first column) and wane (second column). If the number of rows does not match the number of individuals, is not used.
+//' @param indiv_effect_sds NumericVector of length 2, standard deviations of the normal hierarchical prior on the mu and wane random effects. An effect is only updated if its standard deviation is greater than 0.
+//' @param indiv_effect_step double, standard deviation of the random walk proposal on the random effects
+//' @param infection_time_titres NumericMatrix, the titres before each candidate infection time from \code{\link{titres_at_infection_times}} for the current infection histories. If the number of rows matches the number of individuals, these are kept up to date as proposals are accepted, only recomputing the times after the changed entries. Otherwise, is not used. \code{\link{run_MCMC}} does not pass these, as no prior in the package uses them yet
+//' @param shift_propn double, the proportion of sampled individuals that take a shift step rather than the usual proposals. A shift step moves all of the individual's infections, or a contiguous block of them, by between 1 and shift_max time periods in either direction. Every candidate shift is scored with one solve of the individual's titres, and one is picked by multiple-try Metropolis. Individuals without infections take the usual proposals instead, and random effects are updated after either
+//' @param shift_max int, the largest shift in a shift step
 //' @param temp double, temperature for parallel tempering MCMC
 //' @param solve_likelihood bool, if FALSE does not solve likelihood when calculating acceptance probability
-//' @return an R list with 6 entries: 1) the vector replacing old_probs_1, corresponding to the new likelihoods per individual; 2) the matrix of 1s and 0s corresponding to the new infection histories for all individuals; 3-6) the updated entries for proposal_iter, accepted_iter, proposal_swap and accepted_swap.
+//' @param kinetics (optional) user-defined boosting, waning and seniority terms from \code{\link{compile_kinetics}}, which replace the built-in kinetics
+//' @return an R list with 13 entries: 1) the vector replacing old_probs_1, corresponding to the new likelihoods per individual; 2) the matrix of 1s and 0s corresponding to the new infection histories for all individuals; 3-6) the updated entries for proposal_iter, accepted_iter, proposal_swap and accepted_swap; 7-8) the updated overall_swap_proposals and overall_add_proposals; 9) the updated indiv_effects; 10) the number of accepted random effect proposals; 11) the updated infection_time_titres; 12-13) the number of shift steps proposed and accepted.
 //' @export
 //' @family infection_history_proposal
 // [[Rcpp::export]]
@@ -167,10 +170,8 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 				   const IntegerVector &n_years_samp_vec,
 				   const IntegerVector &age_mask, // Age mask
 				   const IntegerVector &strain_mask, // Age mask
-				   const IntegerMatrix &n_alive, // No. of individuals alive each year/group
-				   IntegerMatrix &n_infections, // No. of infections in each year/group
-				   IntegerVector &n_infected_group,
-				   const NumericMatrix &prior_lookup,
+				   SEXP group_counts, // No. of individuals alive and infected each year/group
+				   const bool &prior_on_total,
 				   const double &swap_propn,
 				   const int &swap_distance,
 				   const bool &propose_from_prior,
@@ -184,13 +185,11 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 				   const IntegerVector &cum_nrows_per_individual_in_repeat_data, // How many rows in the repeat titre data correspond to each individual?
 				   const IntegerVector &nrows_per_blood_sample, // How many rows in the titre data table correspond to each unique individual + sample time + repeat?
 				   const IntegerVector &group_id_vec, // Which group does each individual belong to?
-				   const IntegerVector &measurement_strain_indices, // For each titre measurement, corresponding entry in antigenic map
 				   const NumericVector &antigenic_map_long, 
 				   const NumericVector &antigenic_map_short,
 				   const NumericVector &antigenic_distances,
-				   const NumericVector &data,
-				   const NumericVector &repeat_data,
-				   const IntegerVector &repeat_indices,
+				   const RawVector &packed_titres, // Observed titre and antigenic map entry for each titre measurement
+				   const RawVector &packed_repeat_titres, // Observed repeat titres and the titre measurement they repeat
 				   const NumericVector &titre_shifts,
 				   IntegerVector proposal_iter,
 				   IntegerVector accepted_iter,
@@ -201,14 +200,23 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 				   const NumericVector time_sample_probs,
 				   const NumericVector &mus,
 				   const IntegerVector &boosting_vec_indices,
-				   const IntegerVector &total_alive,
+				   const NumericMatrix &indiv_effects,
+				   const NumericVector &indiv_effect_sds,
+				   const double &indiv_effect_step,
+				   const NumericMatrix &infection_time_titres,
+				   const double &shift_propn,
+				   const int &shift_max,
 				   const double temp=1,
-				   bool solve_likelihood=true				   
+				   bool solve_likelihood=true,
+				   const List &kinetics=R_NilValue
 				   ){
   // ########################################################################
   // Parameters to control indexing of data
   IntegerMatrix new_infection_history_mat(infection_history_mat); // Can this be avoided? Create a copy of the inf hist matrix
-  int n_titres_total = data.size(); // How many titres are there in total?
+  int n_titres_total = packed_obs_size(packed_titres); // How many titres are there in total?
+  packed_strain_indices measurement_strain_indices(packed_titres); // Boosting kernels read strain indices straight from the packed records
+  const packed_obs *data = packed_obs_ptr(packed_titres);
+  const packed_obs *repeat_data = packed_obs_ptr(packed_repeat_titres);
   NumericVector predicted_titres(n_titres_total); // Vector to store predicted titres
   NumericVector old_probs = clone(old_probs_1); // Create a copy of the current old probs
   
@@ -220,11 +228,13 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
   int number_strains = infection_history_mat.ncol(); // How many possible years are we interested in?
   int n_sampled = sampled_indivs.size(); // How many individuals are we actually investigating?
   
-  // Using prior version 2 or 4?
-  bool prior_on_total = total_alive(0) > 0;
+  // Number alive and infected in each group and time, with the prior lookup
+  // tables for this alpha and beta
+  Rcpp::XPtr<group_time_counts> counts(group_counts);
+  counts->set_prior(alpha, beta);
 
   //Repeat data?
-  bool repeat_data_exist = repeat_indices[0] >= 0;
+  bool repeat_data_exist = packed_obs_size(packed_repeat_titres) > 0;
   
   // These indices allow us to step through the titre data vector
   // as if it were a matrix ie. number of rows for each individual
@@ -269,11 +279,12 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
   double m; // number of infections in a given year
   double n; // number alive in a particular year
 
-  double m_1_new, m_1_old,m_2_new,m_2_old;
-  // double n_1, n_2;
+  int m_1_new, m_1_old,m_2_new,m_2_old;
+  int n_1, n_2;
   double prior_1_old, prior_2_old, prior_1_new,prior_2_new,prior_new,prior_old;
 
   double rand1; // Store a random number
+  double reject_below; // Likelihood below which the proposal is certain to be rejected
   double ratio; // Store the gibbs ratio for 0 or 1 proposal
 
   double old_prob; // Likelihood of old number
@@ -335,6 +346,99 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
   // 4. Extra titre shifts
   bool use_titre_shifts = false;
   if(titre_shifts.size() == n_titres_total) use_titre_shifts = true;
+
+  // 5. Per-individual random effects on boosting and waning. These are updated with one
+  // extra random walk proposal at the end of each sampled individual's sweep, which only
+  // needs that individual's titres to be re-solved
+  NumericMatrix new_indiv_effects = clone(indiv_effects);
+  bool use_indiv_effects = indiv_effects.nrow() == infection_history_mat.nrow();
+  bool update_mu_effect = use_indiv_effects && indiv_effect_sds(0) > 0;
+  bool update_wane_effect = use_indiv_effects && indiv_effect_sds(1) > 0;
+  bool update_indiv_effects = update_mu_effect || update_wane_effect;
+  bool effect_step = false;
+  int indiv_effect_accepted = 0;
+  double mu_effect = 0, wane_effect = 0, mu_effect_new = 0, wane_effect_new = 0;
+  double mu_indiv = mu, wane_indiv = wane;
+  NumericVector mus_indiv = clone(mus);
+
+  // 6. User-defined kinetics from compile_kinetics replace the built-in kernels
+  kinetics_model kinetics_fns(kinetics, theta);
+
+  // 7. Titres before each candidate infection time, for titre-mediated protection.
+  // After an accepted change at time t, only the times after t need recomputing
+  NumericMatrix new_infection_time_titres = clone(infection_time_titres);
+  bool update_infection_time_titres = infection_time_titres.nrow() == infection_history_mat.nrow();
+  if(update_infection_time_titres && (alternative_wane_func || titre_dependent_boosting || kinetics_fns.used)){
+    Rcpp::stop("Titres at infection times are only available for the base model and strain-dependent boosting");
+  }
+  int first_changed_time;
+
+  // 8. Shift steps. Every shift from -2*shift_max to 2*shift_max is scored, covering both the
+  // candidates around the current history and the reference set around the chosen one
+  bool use_shift_steps = shift_max > 0 && shift_propn > 0;
+  bool shift_step = false;
+  int shift_proposals = 0, shift_accepted = 0;
+  // Individuals with infections take the usual proposals with probability 1 - shift_propn,
+  // and individuals without any always take them. Proposals between no infections and
+  // some are weighted by this, with n_infections_indiv tracking the individual's count
+  double log_no_shift = use_shift_steps ? log1p(-shift_propn) : 0;
+  int n_infections_indiv = 0;
+  int n_shifts = 4*shift_max + 1;
+  std::vector<double> shift_scores(n_shifts);
+  std::vector<double> shift_liks(n_shifts);
+  std::vector<int> infection_positions;
+  // Infection times and strains of a shifted history. Shifts keep the order of the
+  // infections, so these are filled straight from the infection positions, and are only
+  // reallocated when the number of infections differs from the last shift step
+  NumericVector shift_times(0);
+  IntegerVector shift_strain_indices(0);
+
+  // Likelihood of one individual's titres given their infection times and strains, with the
+  // current boosting and waning
+  auto individual_likelihood = [&](const NumericVector &times, const IntegerVector &strain_indices) -> double {
+    if (kinetics_fns.used) {
+      titre_data_fast_individual_kinetics(predicted_titres, kinetics_fns, mu_indiv, wane_indiv,
+					  times, strain_indices, measurement_strain_indices, sample_times,
+					  index_in_samples, end_index_in_samples, start_index_in_data,
+					  nrows_per_blood_sample, number_strains,
+					  antigenic_map_short, antigenic_map_long, false);
+    } else if (base_function) {
+      titre_data_fast_individual_base(predicted_titres, mu_indiv, mu_short, wane_indiv, tau,
+				      times, strain_indices, measurement_strain_indices, sample_times,
+				      index_in_samples, end_index_in_samples, start_index_in_data,
+				      nrows_per_blood_sample, number_strains,
+				      antigenic_map_short, antigenic_map_long, false);
+    } else if (titre_dependent_boosting) {
+      titre_data_fast_individual_titredep(predicted_titres, mu_indiv, mu_short, wane_indiv, tau,
+					  gradient, boost_limit,
+					  times, strain_indices, measurement_strain_indices, sample_times,
+					  index_in_samples, end_index_in_samples, start_index_in_data,
+					  nrows_per_blood_sample, number_strains,
+					  antigenic_map_short, antigenic_map_long, false);
+    } else if (strain_dep_boost) {
+      titre_data_fast_individual_strain_dependent(predicted_titres, mus_indiv, boosting_vec_indices,
+						  mu_short, wane_indiv, tau,
+						  times, strain_indices, measurement_strain_indices, sample_times,
+						  index_in_samples, end_index_in_samples, start_index_in_data,
+						  nrows_per_blood_sample, number_strains,
+						  antigenic_map_short, antigenic_map_long, false);
+    } else {
+      titre_data_fast_individual_wane2(predicted_titres, mu_indiv, mu_short, wane_indiv, tau,
+				       kappa, t_change,
+				       times, strain_indices, measurement_strain_indices, sample_times,
+				       index_in_samples, end_index_in_samples, start_index_in_data,
+				       nrows_per_blood_sample, number_strains,
+				       antigenic_map_short, antigenic_map_long, false);
+    }
+    if(use_titre_shifts){
+      add_measurement_shifts(predicted_titres, titre_shifts, start_index_in_data, end_index_in_data);
+    }
+    double lik = 0;
+    proposal_likelihood_func(lik, predicted_titres, indiv, data, repeat_data,
+			     cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data,
+			     log_const, den, max_titre, repeat_data_exist);
+    return lik;
+  };
   // ########################################################################
   // For each individual
   for(int i = 0; i < n_sampled; ++i){
@@ -369,35 +473,204 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
     }
     samps = seq(0, n_samp_length-1);    // Create vector from 0:length of alive years
 
-    // Extract time sampling probabilities and re-normalise
-    samps_shifted = samps + age_mask[indiv] - 1;
-    tmp_loc_sample_probs = time_sample_probs[samps_shifted];
-    // Re-normalise
-    tmp_loc_sample_probs = tmp_loc_sample_probs/sum(tmp_loc_sample_probs);
-    /*        Rcpp::Rcout << "Indiv: " << indiv << std::endl;
-    Rcpp::Rcout << "Age mask: " << age_mask[indiv] << std::endl;
-    Rcpp::Rcout << "n_samp_length: " << n_samp_length << std::endl;
-    Rcpp::Rcout << "Samps: " << samps << std::endl;
-    Rcpp::Rcout << "Samps shifted: " << samps_shifted << std::endl;
-    Rcpp::Rcout << "Loc sample prob length: " << tmp_loc_sample_probs.size() << std::endl;
-    Rcpp::Rcout << "Tmp loc samples: " << tmp_loc_sample_probs << std::endl;
-    Rcpp::Rcout << "Scaled samps: " << sum(tmp_loc_sample_probs) << std::endl;
-    */
-    locs = RcppArmadillo::sample(samps, n_samp_max, FALSE, tmp_loc_sample_probs);
-    // For each selected infection history entry
-    for(int j = 0; j < n_samp_max; ++j){
+    // This individual's boosting and waning
+    if(use_indiv_effects){
+      mu_effect = new_indiv_effects(indiv,0);
+      wane_effect = new_indiv_effects(indiv,1);
+      mu_indiv = mu*exp(mu_effect);
+      wane_indiv = wane*exp(wane_effect);
+      if(strain_dep_boost){
+	for(int k = 0; k < mus.size(); ++k) mus_indiv[k] = mus[k]*exp(mu_effect);
+      }
+    }
+
+    ///////////////////////////////////////////////////////
+    // OPTION 3: Shift a block of infections in time
+    ///////////////////////////////////////////////////////
+    // A contiguous block of this individual's infections (possibly all of them) is moved
+    // by d time periods, 1 <= |d| <= shift_max. The block is chosen by rank, and shifts that
+    // would pass another infection or leave the masks are not allowed, so the same block is
+    // chosen with the same probability from the shifted history. One candidate shift is
+    // picked in proportion to its posterior and accepted by multiple-try Metropolis. An
+    // individual without infections has nothing to shift, so takes the usual proposals
+    shift_step = false;
+    if(use_shift_steps && R::runif(0,1) < shift_propn){
+      new_infection_history = new_infection_history_mat(indiv,_);
+      infection_positions.clear();
+      for(int t = age_mask[indiv] - 1; t < strain_mask[indiv]; ++t){
+	if(new_infection_history(t) > 0) infection_positions.push_back(t);
+      }
+      shift_step = infection_positions.size() > 0;
+    }
+    if(shift_step){
+      int n_inf = infection_positions.size();
+      int block_start = floor(R::runif(0, n_inf));
+      int block_end = block_start + floor(R::runif(0, n_inf - block_start));
+      int lowest = block_start > 0 ? infection_positions[block_start - 1] + 1 : age_mask[indiv] - 1;
+      int highest = block_end < n_inf - 1 ? infection_positions[block_end + 1] - 1 : strain_mask[indiv] - 1;
+      shift_proposals += 1;
+      if(shift_times.size() != n_inf){
+	shift_times = NumericVector(n_inf);
+	shift_strain_indices = IntegerVector(n_inf);
+      }
+
+      // Prior change from taking the block out of the group counts...
+      double prior_removed = 0;
+      if(!prior_on_total){
+	for(int k = block_start; k <= block_end; ++k){
+	  int t = infection_positions[k];
+	  int n_t = counts->n_alive(group_id, t);
+	  int m_t = counts->n_infections(group_id, t);
+	  prior_removed += counts->prior_lookup(n_t, m_t - 1) - counts->prior_lookup(n_t, m_t);
+	}
+      }
+      // ...and putting it back at each shift
+      for(int k = 0; k < n_shifts; ++k){
+	int d = k - 2*shift_max;
+	if(infection_positions[block_start] + d < lowest || infection_positions[block_end] + d > highest){
+	  shift_scores[k] = R_NegInf;
+	  continue;
+	}
+	if(d == 0){
+	  shift_liks[k] = old_prob;
+	  shift_scores[k] = old_prob/temp;
+	  continue;
+	}
+	double prior_added = 0;
+	for(int j = 0; j < n_inf; ++j){
+	  int t = infection_positions[j] + (j >= block_start && j <= block_end ? d : 0);
+	  shift_times[j] = circulation_times[t];
+	  shift_strain_indices[j] = circulation_times_indices[t];
+	}
+	for(int j = block_start; j <= block_end; ++j){
+	  int t = infection_positions[j] + d;
+	  if(!prior_on_total){
+	    int n_t = counts->n_alive(group_id, t);
+	    // Counts after the block is taken out
+	    int m_t = counts->n_infections(group_id, t) - new_infection_history(t);
+	    prior_added += counts->prior_lookup(n_t, m_t + 1) - counts->prior_lookup(n_t, m_t);
+	  }
+	}
+	shift_liks[k] = solve_likelihood ? individual_likelihood(shift_times, shift_strain_indices) : old_prob;
+	shift_scores[k] = (shift_liks[k] + prior_removed + prior_added)/temp;
+      }
+
+      // Pick a candidate around the current history in proportion to its weight
+      double max_score = R_NegInf;
+      for(int k = shift_max; k <= 3*shift_max; ++k){
+	if(k != 2*shift_max) max_score = std::max(max_score, shift_scores[k]);
+      }
+      // No shift is possible when the block fills the space between its neighbours
+      if(max_score > R_NegInf){
+	double total_forward = 0;
+	for(int k = shift_max; k <= 3*shift_max; ++k){
+	  if(k != 2*shift_max) total_forward += exp(shift_scores[k] - max_score);
+	}
+	double pick = R::runif(0, total_forward);
+	int chosen = -1;
+	for(int k = shift_max; k <= 3*shift_max; ++k){
+	  if(k == 2*shift_max || shift_scores[k] == R_NegInf) continue;
+	  chosen = k;
+	  pick -= exp(shift_scores[k] - max_score);
+	  if(pick <= 0) break;
+	}
+	// Reference set around the chosen history, which includes the current one
+	double total_reverse = 0;
+	for(int k = chosen - shift_max; k <= chosen + shift_max; ++k){
+	  if(k != chosen) total_reverse += exp(shift_scores[k] - max_score);
+	}
+	if(log(R::runif(0,1)) < log(total_forward) - log(total_reverse)){
+	  int d = chosen - 2*shift_max;
+	  shift_accepted += 1;
+	  old_prob = old_probs[indiv] = shift_liks[chosen];
+	  for(int j = block_start; j <= block_end; ++j){
+	    new_infection_history_mat(indiv, infection_positions[j]) = 0;
+	    counts->add_infections(group_id, infection_positions[j], -1);
+	  }
+	  for(int j = block_start; j <= block_end; ++j){
+	    new_infection_history_mat(indiv, infection_positions[j] + d) = 1;
+	    counts->add_infections(group_id, infection_positions[j] + d, 1);
+	  }
+	  first_changed_time = std::min(infection_positions[block_start], infection_positions[block_start] + d) + 1;
+	  if(update_infection_time_titres && first_changed_time < strain_mask[indiv]){
+	    new_infection_history = new_infection_history_mat(indiv,_);
+	    indices = new_infection_history > 0;
+	    infection_times = circulation_times[indices];
+	    infection_strain_indices_tmp = circulation_times_indices[indices];
+	    infection_time_titres_individual(new_infection_time_titres, indiv,
+					     first_changed_time, strain_mask[indiv] - 1,
+					     mu_indiv, mus_indiv, boosting_vec_indices,
+					     mu_short, wane_indiv, tau,
+					     infection_times, infection_strain_indices_tmp,
+					     circulation_times, circulation_times_indices,
+					     number_strains, antigenic_map_short, antigenic_map_long);
+	  }
+	}
+      }
+    }
+
+    if(shift_step){
+      // After a shift step, only the random effects are updated
+      if(!update_indiv_effects) continue;
+      n_samp_max = 0;
+    } else {
+      // Extract time sampling probabilities and re-normalise
+      samps_shifted = samps + age_mask[indiv] - 1;
+      tmp_loc_sample_probs = time_sample_probs[samps_shifted];
+      // Re-normalise
+      tmp_loc_sample_probs = tmp_loc_sample_probs/sum(tmp_loc_sample_probs);
+      /*        Rcpp::Rcout << "Indiv: " << indiv << std::endl;
+      Rcpp::Rcout << "Age mask: " << age_mask[indiv] << std::endl;
+      Rcpp::Rcout << "n_samp_length: " << n_samp_length << std::endl;
+      Rcpp::Rcout << "Samps: " << samps << std::endl;
+      Rcpp::Rcout << "Samps shifted: " << samps_shifted << std::endl;
+      Rcpp::Rcout << "Loc sample prob length: " << tmp_loc_sample_probs.size() << std::endl;
+      Rcpp::Rcout << "Tmp loc samples: " << tmp_loc_sample_probs << std::endl;
+      Rcpp::Rcout << "Scaled samps: " << sum(tmp_loc_sample_probs) << std::endl;
+      */
+      locs = RcppArmadillo::sample(samps, n_samp_max, FALSE, tmp_loc_sample_probs);
+      if(use_shift_steps){
+	n_infections_indiv = 0;
+	for(int t = age_mask[indiv] - 1; t < strain_mask[indiv]; ++t) n_infections_indiv += new_infection_history_mat(indiv,t);
+      }
+    }
+    // For each selected infection history entry, plus the random effects if used
+    for(int j = 0; j < n_samp_max + update_indiv_effects; ++j){
       //Rcpp::Rcout << "j: " << j << std::endl;
       // Assume that proposal hasn't changed likelihood until shown otherwise
       lik_changed = false;
       // Infection history to update
       new_infection_history = new_infection_history_mat(indiv,_);
+      effect_step = j == n_samp_max;
 
+      prior_old = prior_new = 0;
+      ///////////////////////////////////////////////////////
+      // OPTION 0: Random walk on this individual's random effects
+      ///////////////////////////////////////////////////////
+      if(effect_step){
+	lik_changed = true;
+	mu_effect_new = mu_effect;
+	wane_effect_new = wane_effect;
+	if(update_mu_effect){
+	  mu_effect_new += R::rnorm(0, indiv_effect_step);
+	  prior_old += -0.5*mu_effect*mu_effect/(indiv_effect_sds(0)*indiv_effect_sds(0));
+	  prior_new += -0.5*mu_effect_new*mu_effect_new/(indiv_effect_sds(0)*indiv_effect_sds(0));
+	}
+	if(update_wane_effect){
+	  wane_effect_new += R::rnorm(0, indiv_effect_step);
+	  prior_old += -0.5*wane_effect*wane_effect/(indiv_effect_sds(1)*indiv_effect_sds(1));
+	  prior_new += -0.5*wane_effect_new*wane_effect_new/(indiv_effect_sds(1)*indiv_effect_sds(1));
+	}
+	mu_indiv = mu*exp(mu_effect_new);
+	wane_indiv = wane*exp(wane_effect_new);
+	if(strain_dep_boost){
+	  for(int k = 0; k < mus.size(); ++k) mus_indiv[k] = mus[k]*exp(mu_effect_new);
+	}
       ///////////////////////////////////////////////////////
       // OPTION 1: Swap contents of a year for an individual
       ///////////////////////////////////////////////////////
       // If swap step
-      prior_old = prior_new = 0;
-      if(swap_step_option){
+      } else if(swap_step_option){
 	loc1 = locs[j]; // Choose a location from age_mask to strain_mask
 	loc2 = loc1 + floor(R::runif(-swap_distance,swap_distance+1));
 
@@ -434,27 +707,27 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 	  proposal_swap[indiv] += 1;
 	  if(!prior_on_total){
 	    // Number of infections in that group in that time
-	      m_1_old = n_infections(group_id,loc1);      
-	      m_2_old = n_infections(group_id,loc2);
+	      m_1_old = counts->n_infections(group_id,loc1);
+	      m_2_old = counts->n_infections(group_id,loc2);
 	  
 	      // Swap contents
 	      new_infection_history(loc1) = new_infection_history(loc2);
 	      new_infection_history(loc2) = loc1_val_old;
 	  
 	      // Number alive is number alive overall in that time and group
-	      // n_1 = n_alive(group_id, loc1);
-	      // n_2 = n_alive(group_id, loc2);
+	      n_1 = counts->n_alive(group_id, loc1);
+	      n_2 = counts->n_alive(group_id, loc2);
 	    
 	      // Prior for new state
 	      m_1_new = m_1_old - loc1_val_old + loc2_val_old;
 	      m_2_new = m_2_old - loc2_val_old + loc1_val_old;
 
-	      prior_1_old = prior_lookup(m_1_old, loc1);
-	      prior_2_old = prior_lookup(m_2_old, loc2);
+	      prior_1_old = counts->prior_lookup(n_1, m_1_old);
+	      prior_2_old = counts->prior_lookup(n_2, m_2_old);
 	      prior_old = prior_1_old + prior_2_old;
 	      
-	      prior_1_new = prior_lookup(m_1_new, loc1);
-	      prior_2_new = prior_lookup(m_2_new, loc2);
+	      prior_1_new = counts->prior_lookup(n_1, m_1_new);
+	      prior_2_new = counts->prior_lookup(n_2, m_2_new);
 	      prior_new = prior_1_new + prior_2_new;
 	    } else {
 	      // Prior version 4
@@ -476,11 +749,11 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 	  // Get number of individuals that were alive and/or infected in that year,
 	  // less the current individual
 	  // Number of infections in this year, less infection status of this individual in this year
-	  m = n_infections(group_id, year) - old_entry;
-	  n = n_alive(group_id, year) - 1;
+	  m = counts->n_infections(group_id, year) - old_entry;
+	  n = counts->n_alive(group_id, year) - 1;
 	} else {
-	  m = n_infected_group(group_id) - old_entry;
-	  n = total_alive(group_id) - 1;
+	  m = counts->n_infections_group(group_id) - old_entry;
+	  n = counts->n_alive_group(group_id) - 1;
 	}
 
 	if(propose_from_prior){
@@ -509,17 +782,29 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 	  }
 	  m_1_old = m + old_entry;
 	  m_1_new = m + new_entry;
-	  prior_old = prior_lookup(m_1_old, year);
-	  prior_new = prior_lookup(m_1_new, year);
+	  prior_old = counts->prior_lookup(n + 1, m_1_old);
+	  prior_new = counts->prior_lookup(n + 1, m_1_new);
 	}
 	//prior_old = R::lbeta(m_1_old + alpha, n + 1 - m_1_old + beta) - lbeta_const;
 	//prior_new = R::lbeta(m_1_new + alpha, n + 1 - m_1_new + beta) - lbeta_const;
 	if(new_entry != old_entry){
 	  lik_changed = true;
 	  proposal_iter[indiv] += 1;		
+	  if(use_shift_steps && (n_infections_indiv == 0 || n_infections_indiv - old_entry + new_entry == 0)){
+	    if(new_entry > old_entry){
+	      prior_new += temp*log_no_shift;
+	    } else {
+	      prior_old += temp*log_no_shift;
+	    }
+	  }
 	}
 	//Rcpp::Rcout << "New entry: " << new_entry << std::endl;
       }
+      // Uniform for the acceptance step, drawn before solving the likelihood so that the
+      // solve can stop as soon as the proposal is certain to be rejected
+      rand1 = R::runif(0,1);
+      reject_below = R_NegInf;
+
       ////////////////////////
       // If a change was made to the infection history,
       // calculate likelihood of new Z
@@ -533,9 +818,24 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 	// ====================================================== //
 	// =============== CHOOSE MODEL TO SOLVE =============== //
 	// ====================================================== //
-	if (base_function) {
-	  titre_data_fast_individual_base(predicted_titres, mu, mu_short,
-					  wane, tau,
+	if (kinetics_fns.used) {
+	  titre_data_fast_individual_kinetics(predicted_titres, kinetics_fns,
+					      mu_indiv, wane_indiv,
+					      infection_times,
+					      infection_strain_indices_tmp,
+					      measurement_strain_indices,
+					      sample_times,
+					      index_in_samples,
+					      end_index_in_samples,
+					      start_index_in_data,
+					      nrows_per_blood_sample,
+					      number_strains,
+					      antigenic_map_short,
+					      antigenic_map_long,
+					      false);
+	} else if (base_function) {
+	  titre_data_fast_individual_base(predicted_titres, mu_indiv, mu_short,
+					  wane_indiv, tau,
 					  infection_times,
 					  infection_strain_indices_tmp,
 					  measurement_strain_indices,
@@ -549,8 +849,8 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 					  antigenic_map_long,
 					  false);	  
 	} else if (titre_dependent_boosting) {
-	  titre_data_fast_individual_titredep(predicted_titres, mu, mu_short,
-					      wane, tau,
+	  titre_data_fast_individual_titredep(predicted_titres, mu_indiv, mu_short,
+					      wane_indiv, tau,
 					      gradient, boost_limit,
 					      infection_times,
 					      infection_strain_indices_tmp,
@@ -566,9 +866,9 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 					      false);	
 	} else if (strain_dep_boost) {
 	  titre_data_fast_individual_strain_dependent(predicted_titres, 
-						      mus, boosting_vec_indices, 
+						      mus_indiv, boosting_vec_indices, 
 						      mu_short,
-						      wane, tau,
+						      wane_indiv, tau,
 						      infection_times,
 						      infection_strain_indices_tmp,
 						      measurement_strain_indices,
@@ -582,8 +882,8 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 						      antigenic_map_long,
 						      false);
 	} else if(alternative_wane_func){
-	  titre_data_fast_individual_wane2(predicted_titres, mu, mu_short,
-					   wane, tau,
+	  titre_data_fast_individual_wane2(predicted_titres, mu_indiv, mu_short,
+					   wane_indiv, tau,
 					   kappa, t_change,
 					   infection_times,
 					   infection_strain_indices_tmp,
@@ -598,8 +898,8 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 					   antigenic_map_long,
 					   false);
 	} else {
-	  titre_data_fast_individual_base(predicted_titres, mu, mu_short,
-					  wane, tau,
+	  titre_data_fast_individual_base(predicted_titres, mu_indiv, mu_short,
+					  wane_indiv, tau,
 					  infection_times,
 					  infection_strain_indices_tmp,
 					  measurement_strain_indices,
@@ -626,9 +926,11 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
 	// likelihood for this individual
 	// For unique data
 
-	proposal_likelihood_func(new_prob, predicted_titres, indiv, data, repeat_data, repeat_indices,
+	// Accepted only if new_prob > old_prob + prior_old - prior_new + temp*log(rand1)
+	reject_below = old_prob + prior_old - prior_new + temp*log(rand1);
+	proposal_likelihood_func(new_prob, predicted_titres, indiv, data, repeat_data,
 				 cum_nrows_per_individual_in_data, cum_nrows_per_individual_in_repeat_data,
-				 log_const, den, max_titre, repeat_data_exist);
+				 log_const, den, max_titre, repeat_data_exist, reject_below);
 
       } else {
 	old_prob = new_prob = old_probs[indiv];
@@ -645,36 +947,57 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
       //Rcpp::Rcout << "Unmodified log prob: " << (new_prob+prior_new) - (old_prob+prior_old) << std::endl;
       //Rcpp::Rcout << "log prob: " << log_prob << std::endl << std::endl;
       
-      rand1 = R::runif(0,1);
-      if(lik_changed && log(rand1) < log_prob/temp){
+      // A likelihood that stopped early is only a bound, so is never accepted
+      if(lik_changed && !(new_prob < reject_below) && log(rand1) < log_prob/temp){
 	// Update the entry in the new matrix Z1
 	old_prob = new_prob;
 	old_probs[indiv] = new_prob;
 
+	// Keep the new random effects
+	if(effect_step){
+	  first_changed_time = age_mask[indiv] - 1;
+	  indiv_effect_accepted += 1;
+	  mu_effect = new_indiv_effects(indiv,0) = mu_effect_new;
+	  wane_effect = new_indiv_effects(indiv,1) = wane_effect_new;
 	// Carry out the swap
-	if(swap_step_option){
+	} else if(swap_step_option){
+	  first_changed_time = std::min(loc1, loc2) + 1;
 	  accepted_swap[indiv] += 1;
 	  tmp = new_infection_history_mat(indiv,loc1);
 	  new_infection_history_mat(indiv,loc1) = new_infection_history_mat(indiv,loc2);
 	  new_infection_history_mat(indiv,loc2) = tmp;
 	  
-	  // Update number of infections in the two swapped times
-	  if(!prior_on_total){
-	    n_infections(group_id, loc1) = m_1_new;
-	    n_infections(group_id, loc2) = m_2_new;
-	  }
-	  // Don't need to update group infections if prior_on_total, as infections
-	  // only move within an individual (so number in group stays same)
+	  // Update number of infections in the two swapped times. The group total
+	  // stays the same, as infections only move within an individual
+	  counts->add_infections(group_id, loc1, loc2_val_old - loc1_val_old);
+	  counts->add_infections(group_id, loc2, loc1_val_old - loc2_val_old);
 	} else {
+	  first_changed_time = year + 1;
 	  accepted_iter[indiv] += 1;
 	  new_infection_history_mat(indiv,year) = new_entry;	
+	  n_infections_indiv += new_entry - old_entry;
 	  // Update total number of infections in group/time
-	  if(!prior_on_total){
-	    n_infections(group_id, year) -= old_entry;
-	    n_infections(group_id, year) += new_entry;
-	  } else {
-	    n_infected_group(group_id) = n_infected_group(group_id) - old_entry + new_entry;
-	  }
+	  counts->add_infections(group_id, year, new_entry - old_entry);
+	}
+	if(update_infection_time_titres && first_changed_time < strain_mask[indiv]){
+	  new_infection_history = new_infection_history_mat(indiv,_);
+	  indices = new_infection_history > 0;
+	  infection_times = circulation_times[indices];
+	  infection_strain_indices_tmp = circulation_times_indices[indices];
+	  infection_time_titres_individual(new_infection_time_titres, indiv,
+					   first_changed_time, strain_mask[indiv] - 1,
+					   mu_indiv, mus_indiv, boosting_vec_indices,
+					   mu_short, wane_indiv, tau,
+					   infection_times, infection_strain_indices_tmp,
+					   circulation_times, circulation_times_indices,
+					   number_strains, antigenic_map_short, antigenic_map_long);
+	}
+      } else if(effect_step){
+	// Rejected, so go back to the current random effects
+	mu_indiv = mu*exp(mu_effect);
+	wane_indiv = wane*exp(wane_effect);
+	if(strain_dep_boost){
+	  for(int k = 0; k < mus.size(); ++k) mus_indiv[k] = mus[k]*exp(mu_effect);
 	}
       }
     }
@@ -688,5 +1011,10 @@ List inf_hist_prop_prior_v2_and_v4(const NumericVector &theta, // Model paramete
   ret["accepted_swap"] = accepted_swap;
   ret["overall_swap_proposals"] = overall_swap_proposals;
   ret["overall_add_proposals"] = overall_add_proposals;
+  ret["indiv_effects"] = new_indiv_effects;
+  ret["indiv_effect_accepted"] = indiv_effect_accepted;
+  ret["infection_time_titres"] = new_infection_time_titres;
+  ret["shift_proposals"] = shift_proposals;
+  ret["shift_accepted"] = shift_accepted;
   return(ret);
 }
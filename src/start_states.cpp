@@ -0,0 +1,175 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <cstdint>
+#include <vector>
+#include "compact_data.h"
+using namespace Rcpp;
+// [[Rcpp::depends(RcppParallel)]]
+
+// Small counter-based random number generator (splitmix64), so that each thread can draw
+// its own numbers without touching R's generator. Seeded from a seed drawn in R, the chain
+// and the individual, so the result does not depend on how individuals are split across threads
+struct start_state_rng {
+  uint64_t state;
+  start_state_rng(const uint64_t &seed, const uint64_t &chain, const uint64_t &indiv)
+    : state(seed ^ (chain*0x9E3779B97F4A7C15ULL + indiv*0xBF58476D1CE4E5B9ULL)) {}
+  inline double uniform(){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return (z >> 11)*(1.0/9007199254740992.0);
+  }
+};
+
+// Starting infection histories for every chain, one individual at a time. Each individual's
+// titres are read once, and the titre against the nearest measured virus to each time is
+// then shared by all chains
+struct start_state_worker : public RcppParallel::Worker {
+  const packed_obs *obs;
+  const RcppParallel::RVector<int> cum_nrows_per_individual_in_data;
+  const RcppParallel::RVector<int> age_mask;
+  const RcppParallel::RVector<int> strain_mask;
+  const RcppParallel::RVector<double> circulation_times;
+  const RcppParallel::RVector<double> titre_cutoffs;
+  const RcppParallel::RVector<double> sample_probs;
+  const RcppParallel::RVector<double> background_probs;
+  const RcppParallel::RVector<int> seeds;
+  RcppParallel::RVector<int> infection_histories;
+  const int space;
+  const int n_indiv;
+  const int n_times;
+  const int n_chains;
+
+  start_state_worker(const RawVector &packed_titres,
+		     const IntegerVector &cum_nrows_per_individual_in_data,
+		     const IntegerVector &age_mask,
+		     const IntegerVector &strain_mask,
+		     const NumericVector &circulation_times,
+		     const NumericVector &titre_cutoffs,
+		     const NumericVector &sample_probs,
+		     const NumericVector &background_probs,
+		     const IntegerVector &seeds,
+		     IntegerVector &infection_histories,
+		     const int &space)
+    : obs(packed_obs_ptr(packed_titres)),
+      cum_nrows_per_individual_in_data(cum_nrows_per_individual_in_data),
+      age_mask(age_mask), strain_mask(strain_mask), circulation_times(circulation_times),
+      titre_cutoffs(titre_cutoffs), sample_probs(sample_probs), background_probs(background_probs),
+      seeds(seeds), infection_histories(infection_histories), space(space),
+      n_indiv(age_mask.size()), n_times(circulation_times.size()), n_chains(titre_cutoffs.size()) {}
+
+  void operator()(std::size_t begin, std::size_t end){
+    std::vector<double> max_titre(n_times);
+    std::vector<double> titre(n_times);
+    std::vector<int> measured;
+    for(std::size_t i = begin; i < end; ++i){
+      // Highest titre against each measured virus
+      std::fill(max_titre.begin(), max_titre.end(), R_NegInf);
+      for(int x = cum_nrows_per_individual_in_data[i]; x < cum_nrows_per_individual_in_data[i + 1]; ++x){
+	if(obs[x].titre > max_titre[obs[x].index]) max_titre[obs[x].index] = obs[x].titre;
+      }
+      measured.clear();
+      for(int t = 0; t < n_times; ++t){
+	if(max_titre[t] > R_NegInf) measured.push_back(t);
+      }
+      int first = age_mask[i] - 1;
+      int last = strain_mask[i] - 1;
+      if(measured.empty() || last < first) continue;
+
+      // Titre against the nearest measured virus in time to each strain, taking the earlier
+      // virus if two are equally close
+      int k = 0;
+      for(int t = first; t <= last; ++t){
+	while(k + 1 < (int)measured.size() &&
+	      fabs(circulation_times[measured[k + 1]] - circulation_times[t]) <
+	      fabs(circulation_times[measured[k]] - circulation_times[t])) ++k;
+	titre[t] = max_titre[measured[k]];
+      }
+
+      for(int c = 0; c < n_chains; ++c){
+	start_state_rng rng(seeds[c], c, i);
+	int *inf_hist = &infection_histories[(std::size_t)c*n_indiv*n_times];
+	// Move along time, suggesting an infection at the highest titre within each run of
+	// raised titres, with infections at least space apart
+	int t = first - 1;
+	while(t < last){
+	  ++t;
+	  if(titre[t] < titre_cutoffs[c]) continue;
+	  int new_inf = t;
+	  double best_titre = titre[t];
+	  double dist = 0;
+	  while(dist < space && t < last){
+	    ++t;
+	    dist = circulation_times[t] - circulation_times[new_inf];
+	    if(titre[t] > best_titre){
+	      new_inf = t;
+	      best_titre = titre[t];
+	      dist = 0;
+	    }
+	  }
+	  if(rng.uniform() > sample_probs[c]) inf_hist[new_inf*n_indiv + i] = 1;
+	}
+	// Scatter extra infections from the prior, so that chains start further apart
+	if(background_probs[c] > 0){
+	  for(int t = first; t <= last; ++t){
+	    if(rng.uniform() < background_probs[c]) inf_hist[t*n_indiv + i] = 1;
+	  }
+	}
+      }
+    }
+  }
+};
+
+//' Starting infection histories for several chains
+//'
+//' Native version of \code{\link{setup_infection_histories_titre}} for many chains at once. Each individual's titres are read once. Infections are suggested at the highest titre within each run of raised titres (at least \code{space} apart), and each is kept with probability 1 - \code{sample_probs}. Extra infections are then scattered with probability \code{background_probs} at each time that the individual could be infected. Each chain has its own titre cutoff, sample probability and background probability, so that chains start from deliberately different histories. Individuals are spread across threads. Random numbers come from a generator seeded by \code{seeds}, the chain and the individual, so results do not depend on the number of threads.
+//' @param packed_titres RawVector, the packed titre data, see \code{\link{pack_titre_data}}
+//' @param cum_nrows_per_individual_in_data IntegerVector, the cumulative number of titres for each individual, starting at 0
+//' @param age_mask IntegerVector, for each individual, the first time period that they can be infected (indexed from 1)
+//' @param strain_mask IntegerVector, for each individual, the last time period that they can be infected (indexed from 1)
+//' @param circulation_times NumericVector, the times that each strain circulated
+//' @param titre_cutoffs NumericVector, for each chain, how high a titre must be to suggest an infection
+//' @param sample_probs NumericVector, for each chain, the probability of dropping each suggested infection
+//' @param background_probs NumericVector, for each chain, the probability of an extra infection at each time
+//' @param seeds IntegerVector, a random number seed for each chain
+//' @param space int, how many time units must separate suggested infections
+//' @return a list with one IntegerMatrix of infection histories for each chain
+//' @family setup_infection_histories
+//' @export
+// [[Rcpp::export(rng = false)]]
+List setup_infection_histories_chains(const RawVector &packed_titres,
+				      const IntegerVector &cum_nrows_per_individual_in_data,
+				      const IntegerVector &age_mask,
+				      const IntegerVector &strain_mask,
+				      const NumericVector &circulation_times,
+				      const NumericVector &titre_cutoffs,
+				      const NumericVector &sample_probs,
+				      const NumericVector &background_probs,
+				      const IntegerVector &seeds,
+				      int space = 5){
+  int n_indiv = age_mask.size();
+  int n_times = circulation_times.size();
+  int n_chains = titre_cutoffs.size();
+  if(sample_probs.size() != n_chains || background_probs.size() != n_chains || seeds.size() != n_chains){
+    Rcpp::stop("titre_cutoffs, sample_probs, background_probs and seeds must have one entry per chain");
+  }
+  if(strain_mask.size() != n_indiv || cum_nrows_per_individual_in_data.size() != n_indiv + 1){
+    Rcpp::stop("age_mask, strain_mask and cum_nrows_per_individual_in_data do not have the same number of individuals");
+  }
+  IntegerVector infection_histories((std::size_t)n_chains*n_indiv*n_times);
+  start_state_worker worker(packed_titres, cum_nrows_per_individual_in_data, age_mask, strain_mask,
+			    circulation_times, titre_cutoffs, sample_probs, background_probs,
+			    seeds, infection_histories, space);
+  RcppParallel::parallelFor(0, n_indiv, worker);
+
+  List ret(n_chains);
+  for(int c = 0; c < n_chains; ++c){
+    IntegerMatrix inf_hist(n_indiv, n_times);
+    std::copy(infection_histories.begin() + (std::size_t)c*n_indiv*n_times,
+	      infection_histories.begin() + (std::size_t)(c + 1)*n_indiv*n_times,
+	      inf_hist.begin());
+    ret[c] = inf_hist;
+  }
+  return(ret);
+}
@@ -0,0 +1,191 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace Rcpp;
+// [[Rcpp::depends(RcppParallel)]]
+
+// Bandwidth for a Gaussian kernel density estimate, as given by bw.nrd0 in R. Reorders values
+static double bandwidth_nrd0(std::vector<double> &values){
+  int n = values.size();
+  double mean = 0, var = 0;
+  for(int i = 0; i < n; ++i) mean += values[i];
+  mean /= n;
+  for(int i = 0; i < n; ++i) var += (values[i] - mean)*(values[i] - mean);
+  double hi = n > 1 ? sqrt(var/(n - 1)) : 0;
+
+  // Interquartile range from the type 7 quantiles
+  double q[2];
+  double probs[2] = {0.25, 0.75};
+  for(int k = 0; k < 2; ++k){
+    double h = (n - 1)*probs[k];
+    int lo_index = floor(h);
+    std::nth_element(values.begin(), values.begin() + lo_index, values.end());
+    q[k] = values[lo_index];
+    if(lo_index + 1 < n){
+      q[k] += (h - lo_index)*(*std::min_element(values.begin() + lo_index + 1, values.end()) - q[k]);
+    }
+  }
+  double lo = std::min(hi, (q[1] - q[0])/1.34);
+  if(lo <= 0) lo = hi;
+  if(lo <= 0) lo = fabs(values[0]);
+  if(lo <= 0) lo = 1;
+  return 0.9*lo*pow(n, -0.2);
+}
+
+static bool not_finite(const double &x){
+  return !std::isfinite(x);
+}
+
+// Binned Gaussian kernel density estimate for each group of values. Each group is linearly
+// binned onto the grid, and the bins are then smoothed with the kernel truncated at 4
+// bandwidths, so the cost grows with the length of the chain plus the grid size rather
+// than their product. Groups are independent, so are spread across threads
+struct kernel_density_worker : public RcppParallel::Worker {
+  const RcppParallel::RVector<double> values;
+  const RcppParallel::RVector<int> group_starts;
+  RcppParallel::RMatrix<double> grid;
+  RcppParallel::RMatrix<double> density;
+  RcppParallel::RVector<double> bandwidths;
+  const int n_points;
+
+  kernel_density_worker(const NumericVector &values, const IntegerVector &group_starts,
+			NumericMatrix &grid, NumericMatrix &density, NumericVector &bandwidths)
+    : values(values), group_starts(group_starts), grid(grid), density(density),
+      bandwidths(bandwidths), n_points(grid.nrow()) {}
+
+  void operator()(std::size_t begin, std::size_t end){
+    std::vector<double> group_values;
+    std::vector<double> bins(n_points);
+    std::vector<double> kernel;
+    for(std::size_t g = begin; g < end; ++g){
+      group_values.assign(values.begin() + group_starts[g], values.begin() + group_starts[g + 1]);
+      group_values.erase(std::remove_if(group_values.begin(), group_values.end(), not_finite), group_values.end());
+      int n = group_values.size();
+      if(n == 0){
+	for(int k = 0; k < n_points; ++k) grid(k, g) = density(k, g) = NA_REAL;
+	bandwidths[g] = NA_REAL;
+	continue;
+      }
+      double min_value = *std::min_element(group_values.begin(), group_values.end());
+      double max_value = *std::max_element(group_values.begin(), group_values.end());
+      double bw = bandwidth_nrd0(group_values);
+      bandwidths[g] = bw;
+
+      // Grid covers 3 bandwidths beyond the data, as with density(cut = 3)
+      double from = min_value - 3*bw;
+      double dx = (max_value - min_value + 6*bw)/(n_points - 1);
+      for(int k = 0; k < n_points; ++k) grid(k, g) = from + k*dx;
+
+      std::fill(bins.begin(), bins.end(), 0.0);
+      for(int i = 0; i < n; ++i){
+	double pos = (group_values[i] - from)/dx;
+	int lower = std::min(n_points - 2, (int)floor(pos));
+	double frac = pos - lower;
+	bins[lower] += 1 - frac;
+	bins[lower + 1] += frac;
+      }
+
+      // Kernel weights, normalised so that the density integrates to 1 even when the
+      // bandwidth is narrow relative to the grid spacing
+      int half_width = std::min(n_points - 1, (int)ceil(4*bw/dx));
+      kernel.resize(half_width + 1);
+      double kernel_total = 0;
+      for(int k = 0; k <= half_width; ++k){
+	kernel[k] = exp(-0.5*(k*dx/bw)*(k*dx/bw));
+	kernel_total += k == 0 ? kernel[k] : 2*kernel[k];
+      }
+      for(int k = 0; k <= half_width; ++k) kernel[k] /= kernel_total*dx*n;
+
+      for(int k = 0; k < n_points; ++k){
+	double dens = 0;
+	int lower = std::max(0, k - half_width);
+	int upper = std::min(n_points - 1, k + half_width);
+	for(int j = lower; j <= upper; ++j){
+	  if(bins[j] > 0) dens += bins[j]*kernel[std::abs(k - j)];
+	}
+	density(k, g) = dens;
+      }
+    }
+  }
+};
+
+//' Kernel density estimates for groups of MCMC samples
+//'
+//' Gaussian kernel density estimates of several sets of samples at once, eg. for each parameter and chain of an MCMC run. The samples are linearly binned onto the grid before smoothing, and each set is handled on its own thread, so densities of very long chains take seconds. Bandwidths are chosen as by \code{bw.nrd0}.
+//' @param values NumericVector, the samples of all groups, with the samples of each group stored contiguously
+//' @param group_starts IntegerVector, the index (from 0) of the first sample of each group, with a final entry giving the total number of samples
+//' @param n_points int, the number of grid points to estimate each density at
+//' @return a list with the NumericMatrix x of grid points and the NumericMatrix density of density estimates, each with one column per group, and the NumericVector bandwidth used for each group
+//' @family trace_plots
+//' @export
+// [[Rcpp::export(rng = false)]]
+List kernel_density_by_group(const NumericVector &values, const IntegerVector &group_starts, int n_points = 512){
+  int n_groups = group_starts.size() - 1;
+  if(n_groups < 0 || n_points < 2){
+    Rcpp::stop("Need at least one group and two grid points");
+  }
+  NumericMatrix grid(n_points, n_groups);
+  NumericMatrix density(n_points, n_groups);
+  NumericVector bandwidths(n_groups);
+  kernel_density_worker worker(values, group_starts, grid, density, bandwidths);
+  RcppParallel::parallelFor(0, n_groups, worker);
+  List ret;
+  ret["x"] = grid;
+  ret["density"] = density;
+  ret["bandwidth"] = bandwidths;
+  return(ret);
+}
+
+//' Downsample MCMC traces for plotting
+//'
+//' Picks the rows of one or more MCMC traces to draw so that the plotted lines look the same as plotting every row. Each trace is split into n_buckets equal-width buckets of the x axis (roughly one per pixel), and only the first, last, minimum and maximum points of each bucket are kept. The cost is one pass over the traces, and at most 4*n_buckets points are kept per trace regardless of chain length.
+//' @param x NumericVector, the x values (eg. sampno) of all traces, increasing within each trace
+//' @param y NumericVector, the y values of all traces
+//' @param series_starts IntegerVector, the index (from 0) of the first row of each trace, with a final entry giving the total number of rows
+//' @param n_buckets int, the number of buckets to split each trace into
+//' @return IntegerVector of the rows (from 1) to keep, in increasing order
+//' @family trace_plots
+//' @export
+// [[Rcpp::export(rng = false)]]
+IntegerVector downsample_trace(const NumericVector &x, const NumericVector &y,
+			       const IntegerVector &series_starts, int n_buckets = 1000){
+  std::vector<int> keep;
+  int n_series = series_starts.size() - 1;
+  int bucket_rows[4];
+  for(int s = 0; s < n_series; ++s){
+    int start = series_starts[s];
+    int end = series_starts[s + 1];
+    // Short traces are kept whole
+    if(end - start <= 4*n_buckets){
+      for(int i = start; i < end; ++i) keep.push_back(i + 1);
+      continue;
+    }
+    double x0 = x[start];
+    double width = (x[end - 1] - x0)/n_buckets;
+    int bucket = -1;
+    int first = start, last = start, min_row = start, max_row = start;
+    for(int i = start; i <= end; ++i){
+      int new_bucket = i == end ? n_buckets : (width > 0 ? std::min(n_buckets - 1, (int)((x[i] - x0)/width)) : 0);
+      if(new_bucket != bucket){
+	// Close off the last bucket, keeping its points in x order
+	if(bucket >= 0){
+	  bucket_rows[0] = first; bucket_rows[1] = last; bucket_rows[2] = min_row; bucket_rows[3] = max_row;
+	  std::sort(bucket_rows, bucket_rows + 4);
+	  for(int k = 0; k < 4; ++k){
+	    if(k == 0 || bucket_rows[k] != bucket_rows[k - 1]) keep.push_back(bucket_rows[k] + 1);
+	  }
+	}
+	if(i == end) break;
+	bucket = new_bucket;
+	first = last = min_row = max_row = i;
+      } else {
+	last = i;
+	if(y[i] < y[min_row]) min_row = i;
+	if(y[i] > y[max_row]) max_row = i;
+      }
+    }
+  }
+  return(wrap(keep));
+}